@@ -1,3 +1,5 @@
+#pragma once
+
 #include "Order.cpp"
 
 // Provide an implementation for the OrderCacheInterface interface class.
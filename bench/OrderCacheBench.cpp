@@ -0,0 +1,713 @@
+// bench/OrderCacheBench.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+#include "../include/AsyncOrderCache.h"
+#include "../include/OrderCache.h"
+#include "../include/ShardedOrderCache.h"
+#include "../include/QtyKernels.h"
+#include "../include/OrderIdIndex.h"
+#include "WorkloadGenerator.h"
+
+namespace {
+
+// Resting orders of a book with the given size and cardinalities, no cancels.
+std::vector<Order> makeBook(std::size_t bookSize, std::size_t securities, std::size_t users,
+                            const std::string& idPrefix = "OrdId", std::uint64_t seed = 42) {
+    WorkloadConfig config;
+    config.seed = seed;
+    config.events = bookSize;
+    config.securities = securities;
+    config.users = users;
+    config.cancelRatio = 0;
+    config.idPrefix = idPrefix;
+
+    std::vector<Order> book;
+    book.reserve(bookSize);
+    for (auto& event : WorkloadGenerator(config).generate()) {
+        book.push_back(std::move(event.order));
+    }
+    return book;
+}
+
+// Book described by the benchmark arguments: {bookSize, securities, users}.
+std::vector<Order> makeBook(const benchmark::State& state) {
+    return makeBook(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)),
+                    static_cast<std::size_t>(state.range(2)));
+}
+
+// Distinct values of one string field across the book.
+template <class Field>
+std::vector<std::string> distinct(const std::vector<Order>& book, Field field) {
+    std::set<std::string> values;
+    for (const auto& order : book) {
+        values.insert((order.*field)());
+    }
+    return {values.begin(), values.end()};
+}
+
+template <class Cache>
+void fill(Cache& cache, const std::vector<Order>& book) {
+    for (const auto& order : book) {
+        cache.addOrder(order);
+    }
+}
+
+// Book sizes crossed with low and high user/security cardinality.
+void bookArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"orders", "securities", "users"});
+    for (std::int64_t orders : {10000, 100000, 1000000}) {
+        bench->Args({orders, 100, 500});
+        bench->Args({orders, 5000, 20000});
+    }
+    bench->Unit(benchmark::kMillisecond);
+}
+
+template <class Cache>
+void BM_AddOrder(benchmark::State& state) {
+    auto book = makeBook(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto cache = std::make_unique<Cache>();
+        state.ResumeTiming();
+
+        fill(*cache, book);
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+template <class Cache>
+void BM_AddOrdersBatch(benchmark::State& state) {
+    auto book = makeBook(state);
+    auto batchSize = static_cast<std::size_t>(state.range(3));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto cache = std::make_unique<Cache>();
+        std::vector<std::vector<Order>> batches;
+        for (std::size_t begin = 0; begin < book.size(); begin += batchSize) {
+            auto end = book.begin() + std::min(book.size(), begin + batchSize);
+            batches.emplace_back(book.begin() + begin, end);
+        }
+        state.ResumeTiming();
+
+        for (auto& batch : batches) {
+            cache->addOrders(std::move(batch));
+        }
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+// One writer ingesting while range(4) threads keep querying the same cache. Per-order adds
+// (batch 1) queue for the exclusive lock behind the readers on every order, addOrders once per batch.
+void BM_AddOrdersUnderReaders(benchmark::State& state) {
+    auto book = makeBook(state);
+    auto batchSize = static_cast<std::size_t>(state.range(3));
+    auto securities = distinct(book, &Order::securityId);
+    for (auto _ : state) {
+        state.PauseTiming();
+        OrderCache cache;
+        std::vector<std::vector<Order>> batches;
+        for (std::size_t begin = 0; begin < book.size(); begin += batchSize) {
+            auto end = book.begin() + std::min(book.size(), begin + batchSize);
+            batches.emplace_back(book.begin() + begin, end);
+        }
+        std::atomic<bool> done{false};
+        std::vector<std::thread> readers;
+        for (std::int64_t r = 0; r < state.range(4); ++r) {
+            readers.emplace_back([&cache, &done, &securities, r] {
+                for (std::size_t i = static_cast<std::size_t>(r); !done.load(std::memory_order_relaxed); ++i) {
+                    benchmark::DoNotOptimize(cache.getMatchingSizeForSecurity(securities[i % securities.size()]));
+                }
+            });
+        }
+        state.ResumeTiming();
+
+        if (batchSize == 1) {
+            fill(cache, book);
+        } else {
+            for (auto& batch : batches) {
+                cache.addOrders(std::move(batch));
+            }
+        }
+
+        state.PauseTiming();
+        done.store(true, std::memory_order_relaxed);
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+template <class Cache>
+void BM_CancelOrder(benchmark::State& state) {
+    auto book = makeBook(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto cache = std::make_unique<Cache>();
+        fill(*cache, book);
+        state.ResumeTiming();
+
+        for (const auto& order : book) {
+            cache->cancelOrder(order.orderId());
+        }
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+template <class Cache>
+void BM_CancelOrdersForUser(benchmark::State& state) {
+    auto book = makeBook(state);
+    auto users = distinct(book, &Order::user);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto cache = std::make_unique<Cache>();
+        fill(*cache, book);
+        state.ResumeTiming();
+
+        for (const auto& user : users) {
+            cache->cancelOrdersForUser(user);
+        }
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+template <class Cache>
+void BM_CancelOrdersForSecIdWithMinimumQty(benchmark::State& state) {
+    auto book = makeBook(state);
+    auto securities = distinct(book, &Order::securityId);
+    // Pull roughly the largest 10% of orders of every security
+    unsigned int minQty = WorkloadConfig().maxQty * 9 / 10;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto cache = std::make_unique<Cache>();
+        fill(*cache, book);
+        state.ResumeTiming();
+
+        for (const auto& securityId : securities) {
+            cache->cancelOrdersForSecIdWithMinimumQty(securityId, minQty);
+        }
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * securities.size());
+}
+
+template <class Cache>
+void BM_GetQtyTotalsForSecIdWithMinimumQty(benchmark::State& state) {
+    auto book = makeBook(state);
+    auto securities = distinct(book, &Order::securityId);
+    unsigned int minQty = WorkloadConfig().maxQty * 9 / 10;
+    Cache cache;
+    fill(cache, book);
+    for (auto _ : state) {
+        for (const auto& securityId : securities) {
+            benchmark::DoNotOptimize(cache.getQtyTotalsForSecIdWithMinimumQty(securityId, minQty));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * securities.size());
+}
+
+template <class Cache>
+void BM_GetMatchingSizeForSecurity(benchmark::State& state) {
+    auto book = makeBook(state);
+    auto securities = distinct(book, &Order::securityId);
+    Cache cache;
+    fill(cache, book);
+    for (auto _ : state) {
+        for (const auto& securityId : securities) {
+            benchmark::DoNotOptimize(cache.getMatchingSizeForSecurity(securityId));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * securities.size());
+}
+
+// End-of-interval report: every security's matching size in one call, on range(3) threads.
+template <class Cache>
+void BM_GetMatchingSizeForAllSecurities(benchmark::State& state) {
+    auto book = makeBook(state);
+    Cache cache;
+    cache.setParallelism(static_cast<std::size_t>(state.range(3)));
+    fill(cache, book);
+    std::size_t securities = 0;
+    for (auto _ : state) {
+        auto report = cache.getMatchingSizeForAllSecurities();
+        securities = report.size();
+        benchmark::DoNotOptimize(report);
+    }
+    state.SetItemsProcessed(state.iterations() * securities);
+}
+
+// One market maker with range(0) orders over range(1) securities cancelled in one call, on range(2) threads.
+template <class Cache>
+void BM_CancelMarketMaker(benchmark::State& state) {
+    auto book = makeBook(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)), 1);
+    std::string marketMaker = book.front().user();
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto cache = std::make_unique<Cache>();
+        cache->setParallelism(static_cast<std::size_t>(state.range(2)));
+        fill(*cache, book);
+        state.ResumeTiming();
+
+        cache->cancelOrdersForUser(marketMaker);
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+// Thread counts for the parallel paths; 1 is the serial path.
+void parallelismArgs(benchmark::internal::Benchmark* bench, std::vector<std::int64_t> fixed) {
+    for (std::int64_t threads : {1, 2, 4, 8, 16, 32}) {
+        std::vector<std::int64_t> args = fixed;
+        args.push_back(threads);
+        bench->Args(args);
+    }
+    bench->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+template <class Cache>
+void BM_GetAllOrders(benchmark::State& state) {
+    auto book = makeBook(state);
+    Cache cache;
+    fill(cache, book);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.getAllOrders());
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+template <class Cache>
+void BM_VisitOrdersById(benchmark::State& state) {
+    auto book = makeBook(state);
+    Cache cache;
+    fill(cache, book);
+    for (auto _ : state) {
+        std::uint64_t totalQty = 0;
+        cache.visitOrdersById([&totalQty](const OrderView& order) { totalQty += order.qty; });
+        benchmark::DoNotOptimize(totalQty);
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+// getAllOrders and the sorted stream when the ordered-by-orderId view is maintained.
+void BM_GetAllOrdersOrderedView(benchmark::State& state) {
+    auto book = makeBook(state);
+    OrderCache cache;
+    cache.setOrderedViewEnabled(true);
+    fill(cache, book);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.getAllOrders());
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+void BM_VisitOrdersByIdOrderedView(benchmark::State& state) {
+    auto book = makeBook(state);
+    OrderCache cache;
+    cache.setOrderedViewEnabled(true);
+    fill(cache, book);
+    for (auto _ : state) {
+        std::uint64_t totalQty = 0;
+        cache.visitOrdersById([&totalQty](const OrderView& order) { totalQty += order.qty; });
+        benchmark::DoNotOptimize(totalQty);
+    }
+    state.SetItemsProcessed(state.iterations() * book.size());
+}
+
+// Min-qty totals the way the cache computed them before the columnar store:
+// walking Order objects one order at a time.
+void BM_SecurityScanOrderLoop(benchmark::State& state) {
+    auto orders = makeBook(static_cast<std::size_t>(state.range(0)), 1, 500);
+    unsigned int minQty = WorkloadConfig().maxQty * 9 / 10;
+    for (auto _ : state) {
+        QtyTotals large;
+        for (const auto& order : orders) {
+            if (order.qty() >= minQty) {
+                ++large.orders;
+                large.qty += order.qty();
+            }
+        }
+        benchmark::DoNotOptimize(large);
+    }
+    state.SetItemsProcessed(state.iterations() * orders.size());
+}
+
+// The same totals over a qty column with the kernels of one instruction set (range(1)).
+void BM_SecurityScanKernels(benchmark::State& state) {
+    const QtyKernels* kernels = QtyKernels::forIsa(static_cast<KernelIsa>(state.range(1)));
+    if (!kernels) {
+        state.SkipWithError("instruction set not supported by this CPU");
+        return;
+    }
+    auto orders = makeBook(static_cast<std::size_t>(state.range(0)), 1, 500);
+    std::vector<std::uint32_t> qty;
+    for (const auto& order : orders) {
+        qty.push_back(order.qty());
+    }
+    unsigned int minQty = WorkloadConfig().maxQty * 9 / 10;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels->totalsAtLeast(qty.data(), qty.size(), minQty));
+    }
+    state.SetItemsProcessed(state.iterations() * orders.size());
+}
+
+void scanArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"orders", "isa"});
+    for (std::int64_t orders : {1000, 100000}) {
+        for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::SSE4, KernelIsa::AVX2}) {
+            bench->Args({orders, static_cast<std::int64_t>(isa)});
+        }
+    }
+}
+
+// Order IDs addressed by handle, like the IDs in an OrderBook's records.
+std::vector<std::string> makeOrderIds(std::size_t count) {
+    std::vector<std::string> ids;
+    ids.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ids.push_back("OrdId" + std::to_string(i));
+    }
+    return ids;
+}
+
+// The order-ID index OrderBook used before OrderIdIndex: a node-based map from views of the IDs.
+struct UnorderedIdIndex {
+    explicit UnorderedIdIndex(const std::vector<std::string>& ids) : ids(ids), map(&arena) {}
+
+    void insert(std::uint32_t handle) { map.emplace(ids[handle], handle); }
+
+    std::uint32_t find(const std::string& id) const {
+        auto iter = map.find(id);
+        return iter != map.end() ? iter->second : OrderIdIndex::npos;
+    }
+
+    const std::vector<std::string>& ids;
+    OrderArena arena;
+    std::pmr::unordered_map<std::string_view, std::uint32_t> map;
+};
+
+// OrderIdIndex used the way OrderBook uses it.
+struct FlatIdIndex {
+    explicit FlatIdIndex(const std::vector<std::string>& ids) : ids(ids) {}
+
+    void insert(std::uint32_t handle) { index.insert(OrderIdIndex::hash(ids[handle]), handle); }
+
+    std::uint32_t find(const std::string& id) const {
+        return index.find(OrderIdIndex::hash(id), [&](std::uint32_t handle) { return ids[handle] == id; });
+    }
+
+    const std::vector<std::string>& ids;
+    OrderIdIndex index;
+};
+
+// Fills an empty index with range(0) IDs, growing it from scratch.
+template <class Index>
+void BM_OrderIdIndexInsert(benchmark::State& state) {
+    auto ids = makeOrderIds(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        Index index(ids);
+        for (std::size_t handle = 0; handle < ids.size(); ++handle) {
+            index.insert(static_cast<std::uint32_t>(handle));
+        }
+        benchmark::DoNotOptimize(index);
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+// The same fill timing each insert: worstInsertUs shows whether growth stalls a single call.
+template <class Index>
+void BM_OrderIdIndexWorstInsert(benchmark::State& state) {
+    using Clock = std::chrono::steady_clock;
+    auto ids = makeOrderIds(static_cast<std::size_t>(state.range(0)));
+    Clock::duration worst{};
+    for (auto _ : state) {
+        Index index(ids);
+        for (std::size_t handle = 0; handle < ids.size(); ++handle) {
+            auto start = Clock::now();
+            index.insert(static_cast<std::uint32_t>(handle));
+            worst = std::max(worst, Clock::now() - start);
+        }
+        benchmark::DoNotOptimize(index);
+    }
+    state.counters["worstInsertUs"] = std::chrono::duration<double, std::micro>(worst).count();
+}
+
+// Looks every ID of a range(0)-entry index up once, in random order.
+template <class Index>
+void BM_OrderIdIndexFind(benchmark::State& state) {
+    auto ids = makeOrderIds(static_cast<std::size_t>(state.range(0)));
+    Index index(ids);
+    for (std::size_t handle = 0; handle < ids.size(); ++handle) {
+        index.insert(static_cast<std::uint32_t>(handle));
+    }
+    std::vector<std::string> lookups = ids;
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64(42));
+    for (auto _ : state) {
+        for (const auto& id : lookups) {
+            benchmark::DoNotOptimize(index.find(id));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * lookups.size());
+}
+
+void indexArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("orders")->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+}
+
+// Events replayed by BM_Replay: the file named by ORDERCACHE_REPLAY_FILE, or a synthetic day.
+const std::vector<WorkloadEvent>& replayEvents() {
+    static const std::vector<WorkloadEvent> events = [] {
+        if (const char* path = std::getenv("ORDERCACHE_REPLAY_FILE")) {
+            return WorkloadGenerator::load(path);
+        }
+        WorkloadConfig config;
+        config.events = 1000000;
+        return WorkloadGenerator(config).generate();
+    }();
+    return events;
+}
+
+template <class Cache>
+void BM_Replay(benchmark::State& state) {
+    const auto& events = replayEvents();
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto cache = std::make_unique<Cache>();
+        state.ResumeTiming();
+
+        for (const auto& event : events) {
+            if (event.type == WorkloadEvent::Type::Add) {
+                cache->addOrder(event.order);
+            } else {
+                cache->cancelOrder(event.orderId);
+            }
+        }
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+// Warm restart of the state BM_Replay builds, from a snapshot written once beforehand.
+// range(0) is the number of replayed events left in the journal after the snapshot.
+void BM_WarmRestart(benchmark::State& state) {
+    const auto& events = replayEvents();
+    std::size_t tail = std::min(static_cast<std::size_t>(state.range(0)), events.size());
+    std::string directory = (std::filesystem::temp_directory_path() / "OrderCacheBench-WarmRestart").string();
+    std::filesystem::remove_all(directory);
+    {
+        OrderCache cache;
+        cache.enablePersistence(directory);
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            if (i == events.size() - tail) {
+                cache.checkpoint();
+            }
+            const auto& event = events[i];
+            if (event.type == WorkloadEvent::Type::Add) {
+                cache.addOrder(event.order);
+            } else {
+                cache.cancelOrder(event.orderId);
+            }
+        }
+        if (tail == 0) {
+            cache.checkpoint();
+        }
+    }
+
+    for (auto _ : state) {
+        auto cache = std::make_unique<OrderCache>();
+        auto stats = cache->enablePersistence(directory);
+        benchmark::DoNotOptimize(stats);
+
+        state.PauseTiming();
+        cache.reset();
+        state.ResumeTiming();
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// Cache shared by the threads of BM_ConcurrentFlow, created and destroyed outside the timed region.
+std::unique_ptr<OrderCacheInterface> sharedCache;
+
+template <class Cache>
+void setUpSharedCache(const benchmark::State&) {
+    sharedCache = std::make_unique<Cache>();
+}
+
+void tearDownSharedCache(const benchmark::State&) {
+    sharedCache.reset();
+}
+
+// Every thread replays its own skewed add/cancel stream against one shared cache.
+// With disjoint securities per thread (range(0) == 1) a sharded cache should scale with cores.
+template <class Cache>
+void BM_ConcurrentFlow(benchmark::State& state) {
+    bool disjointSecurities = state.range(0) != 0;
+    WorkloadConfig config;
+    config.seed = 1000 + state.thread_index();
+    config.events = 200000;
+    config.idPrefix = "T" + std::to_string(state.thread_index()) + "-";
+    auto events = WorkloadGenerator(config).generate();
+    if (disjointSecurities) {
+        std::string suffix = "-T" + std::to_string(state.thread_index());
+        for (auto& event : events) {
+            if (event.type == WorkloadEvent::Type::Add) {
+                const auto& o = event.order;
+                event.order = Order(o.orderId(), o.securityId() + suffix, o.side(), o.qty(), o.user(), o.company());
+            }
+        }
+    }
+
+    for (auto _ : state) {
+        for (const auto& event : events) {
+            if (event.type == WorkloadEvent::Type::Add) {
+                sharedCache->addOrder(event.order);
+            } else {
+                sharedCache->cancelOrder(event.orderId);
+            }
+        }
+        // Drain what this thread left so every iteration starts from the same book
+        state.PauseTiming();
+        for (const auto& event : events) {
+            sharedCache->cancelOrder(event.orderId);
+        }
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+// Adds each producer makes in BM_ProducerAddOrder.
+constexpr std::int64_t producerOrders = 50000;
+
+// The async cache with a ring that takes every producer's adds without making anyone wait,
+// so BM_ProducerAddOrder sees the enqueue itself rather than the applier's pace.
+void setUpAsyncCache(const benchmark::State& state) {
+    AsyncOrderCacheOptions options;
+    options.capacity = static_cast<std::size_t>(producerOrders * state.threads());
+    sharedCache = std::make_unique<AsyncOrderCache>(options);
+}
+
+// What addOrder costs the calling thread when producers share one cache: the locked
+// update for OrderCache, a ring enqueue for AsyncOrderCache.
+template <class Cache>
+void BM_ProducerAddOrder(benchmark::State& state) {
+    std::string prefix = "T" + std::to_string(state.thread_index()) + "-";
+    auto orders = makeBook(static_cast<std::size_t>(producerOrders), 1000, 5000, prefix,
+                           static_cast<std::uint64_t>(state.thread_index()));
+    std::size_t next = 0;
+    for (auto _ : state) {
+        sharedCache->addOrder(std::move(orders[next++]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (auto* async = dynamic_cast<AsyncOrderCache*>(sharedCache.get()); async && state.thread_index() == 0) {
+        state.counters["stalls"] = static_cast<double>(async->producerStalls());
+    }
+}
+
+void threadArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("disjoint")->Arg(0)->Arg(1);
+    bench->ThreadRange(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_AddOrder, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_AddOrder, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_AddOrdersBatch, OrderCache)
+    ->ArgNames({"orders", "securities", "users", "batch"})
+    ->Args({100000, 1000, 5000, 1})->Args({100000, 1000, 5000, 100})->Args({100000, 1000, 5000, 1000})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_AddOrdersBatch, ShardedOrderCache)
+    ->ArgNames({"orders", "securities", "users", "batch"})
+    ->Args({100000, 1000, 5000, 1})->Args({100000, 1000, 5000, 100})->Args({100000, 1000, 5000, 1000})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AddOrdersUnderReaders)
+    ->ArgNames({"orders", "securities", "users", "batch", "readers"})
+    ->Args({100000, 1000, 5000, 1, 2})->Args({100000, 1000, 5000, 100, 2})->Args({100000, 1000, 5000, 1000, 2})
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CancelOrder, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_CancelOrder, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_CancelOrdersForUser, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_CancelOrdersForUser, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_CancelOrdersForSecIdWithMinimumQty, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_CancelOrdersForSecIdWithMinimumQty, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_GetQtyTotalsForSecIdWithMinimumQty, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_GetQtyTotalsForSecIdWithMinimumQty, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_GetMatchingSizeForSecurity, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_GetMatchingSizeForSecurity, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_GetMatchingSizeForAllSecurities, OrderCache)
+    ->ArgNames({"orders", "securities", "users", "threads"})
+    ->Apply([](benchmark::internal::Benchmark* bench) { parallelismArgs(bench, {1000000, 5000, 20000}); });
+BENCHMARK_TEMPLATE(BM_GetMatchingSizeForAllSecurities, ShardedOrderCache)
+    ->ArgNames({"orders", "securities", "users", "threads"})
+    ->Apply([](benchmark::internal::Benchmark* bench) { parallelismArgs(bench, {1000000, 5000, 20000}); });
+BENCHMARK_TEMPLATE(BM_CancelMarketMaker, OrderCache)
+    ->ArgNames({"orders", "securities", "threads"})
+    ->Apply([](benchmark::internal::Benchmark* bench) { parallelismArgs(bench, {200000, 5000}); });
+BENCHMARK_TEMPLATE(BM_CancelMarketMaker, ShardedOrderCache)
+    ->ArgNames({"orders", "securities", "threads"})
+    ->Apply([](benchmark::internal::Benchmark* bench) { parallelismArgs(bench, {200000, 5000}); });
+BENCHMARK_TEMPLATE(BM_GetAllOrders, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_GetAllOrders, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK(BM_GetAllOrdersOrderedView)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_VisitOrdersById, OrderCache)->Apply(bookArgs);
+BENCHMARK_TEMPLATE(BM_VisitOrdersById, ShardedOrderCache)->Apply(bookArgs);
+BENCHMARK(BM_VisitOrdersByIdOrderedView)->Apply(bookArgs);
+BENCHMARK(BM_SecurityScanOrderLoop)->ArgName("orders")->Arg(1000)->Arg(100000);
+BENCHMARK(BM_SecurityScanKernels)->Apply(scanArgs);
+BENCHMARK_TEMPLATE(BM_OrderIdIndexInsert, UnorderedIdIndex)->Apply(indexArgs);
+BENCHMARK_TEMPLATE(BM_OrderIdIndexInsert, FlatIdIndex)->Apply(indexArgs);
+BENCHMARK_TEMPLATE(BM_OrderIdIndexWorstInsert, UnorderedIdIndex)->Apply(indexArgs)->Iterations(1);
+BENCHMARK_TEMPLATE(BM_OrderIdIndexWorstInsert, FlatIdIndex)->Apply(indexArgs)->Iterations(1);
+BENCHMARK_TEMPLATE(BM_OrderIdIndexFind, UnorderedIdIndex)->Apply(indexArgs);
+BENCHMARK_TEMPLATE(BM_OrderIdIndexFind, FlatIdIndex)->Apply(indexArgs);
+BENCHMARK_TEMPLATE(BM_Replay, OrderCache)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Replay, ShardedOrderCache)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WarmRestart)->ArgName("journalTail")->Arg(0)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ConcurrentFlow, OrderCache)
+    ->Apply(threadArgs)->Setup(setUpSharedCache<OrderCache>)->Teardown(tearDownSharedCache);
+BENCHMARK_TEMPLATE(BM_ConcurrentFlow, ShardedOrderCache)
+    ->Apply(threadArgs)->Setup(setUpSharedCache<ShardedOrderCache>)->Teardown(tearDownSharedCache);
+BENCHMARK_TEMPLATE(BM_ProducerAddOrder, OrderCache)
+    ->Iterations(producerOrders)->ThreadRange(1, 8)->Setup(setUpSharedCache<OrderCache>)->Teardown(tearDownSharedCache);
+BENCHMARK_TEMPLATE(BM_ProducerAddOrder, AsyncOrderCache)
+    ->Iterations(producerOrders)->ThreadRange(1, 8)->Setup(setUpAsyncCache)->Teardown(tearDownSharedCache);
+
+BENCHMARK_MAIN();
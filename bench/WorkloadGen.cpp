@@ -0,0 +1,35 @@
+// bench/WorkloadGen.cpp
+//
+// Writes a reproducible synthetic order flow for OrderCacheBench's BM_Replay:
+//   OrderCacheWorkloadGen <output> [events] [securities] [users] [seed]
+//   ORDERCACHE_REPLAY_FILE=<output> ./OrderCacheBench --benchmark_filter=BM_Replay
+
+#include <cstdlib>
+#include <iostream>
+
+#include "WorkloadGenerator.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <output> [events] [securities] [users] [seed]\n";
+        return 1;
+    }
+
+    WorkloadConfig config;
+    if (argc > 2) config.events = std::strtoull(argv[2], nullptr, 10);
+    if (argc > 3) config.securities = std::strtoull(argv[3], nullptr, 10);
+    if (argc > 4) config.users = std::strtoull(argv[4], nullptr, 10);
+    if (argc > 5) config.seed = std::strtoull(argv[5], nullptr, 10);
+    if (config.securities == 0 || config.users == 0) {
+        std::cerr << "securities and users must be positive\n";
+        return 1;
+    }
+
+    auto events = WorkloadGenerator(config).generate();
+    if (!WorkloadGenerator::save(argv[1], events)) {
+        std::cerr << "failed to write " << argv[1] << "\n";
+        return 1;
+    }
+    std::cout << "wrote " << events.size() << " events to " << argv[1] << "\n";
+    return 0;
+}
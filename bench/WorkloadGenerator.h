@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Order.cpp"
+
+// One entry of an order flow: either an order to add or the ID of an order to cancel.
+struct WorkloadEvent {
+    enum class Type { Add, Cancel };
+
+    Type type;
+    Order order;          // valid for Add
+    std::string orderId;  // valid for both
+};
+
+// Shape of a synthetic order flow.
+struct WorkloadConfig {
+    std::uint64_t seed = 42;
+    std::size_t events = 100000;
+    std::size_t securities = 1000;
+    std::size_t users = 5000;
+    std::size_t companies = 50;
+    double securitySkew = 1.1;   // Zipf exponent over securities
+    double userSkew = 1.0;       // Zipf exponent over users
+    double cancelRatio = 0.4;    // share of events that cancel a resting order
+    unsigned int maxQty = 10000;
+    std::string idPrefix = "OrdId"; // distinct prefixes keep concurrent streams' IDs apart
+};
+
+// Samples ranks 0..n-1 with probability proportional to 1 / (rank + 1)^skew.
+class ZipfDistribution {
+
+    public:
+        ZipfDistribution(std::size_t n, double skew) : cdf(n) {
+            double sum = 0;
+            for (std::size_t rank = 0; rank < n; ++rank) {
+                sum += 1.0 / std::pow(static_cast<double>(rank + 1), skew);
+                cdf[rank] = sum;
+            }
+            for (auto& value : cdf) {
+                value /= sum;
+            }
+        }
+
+        // Uses the raw engine output only, so the sequence is identical on every platform.
+        std::size_t operator()(std::mt19937_64& rng) const {
+            double u = static_cast<double>(rng() >> 11) * 0x1.0p-53;
+            auto rank = static_cast<std::size_t>(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+            return std::min(rank, cdf.size() - 1);
+        }
+
+    private:
+        std::vector<double> cdf;
+};
+
+// Produces reproducible add/cancel streams with Zipf skew over securities and users,
+// and saves/loads them as text so recorded or synthetic flows can be replayed.
+class WorkloadGenerator {
+
+    public:
+        explicit WorkloadGenerator(const WorkloadConfig& config) : config(config) {}
+
+        // Generates the configured number of events. Cancels always target a resting order.
+        std::vector<WorkloadEvent> generate() const {
+            std::mt19937_64 rng(config.seed);
+            ZipfDistribution securityDist(config.securities, config.securitySkew);
+            ZipfDistribution userDist(config.users, config.userSkew);
+
+            std::vector<WorkloadEvent> events;
+            events.reserve(config.events);
+            std::vector<std::string> resting;
+            std::uint64_t nextOrderId = 0;
+
+            for (std::size_t i = 0; i < config.events; ++i) {
+                bool cancel = !resting.empty() && static_cast<double>(rng() >> 11) * 0x1.0p-53 < config.cancelRatio;
+                if (cancel) {
+                    // Swap-remove a random resting order
+                    std::size_t pick = rng() % resting.size();
+                    std::swap(resting[pick], resting.back());
+                    events.push_back({WorkloadEvent::Type::Cancel, Order(), std::move(resting.back())});
+                    resting.pop_back();
+                    continue;
+                }
+
+                std::size_t user = userDist(rng);
+                std::string orderId = config.idPrefix + std::to_string(nextOrderId++);
+                Order order(orderId, "SecId" + std::to_string(securityDist(rng)), (rng() & 1) ? "Buy" : "Sell",
+                            static_cast<unsigned int>(rng() % config.maxQty) + 1, "User" + std::to_string(user),
+                            "Company" + std::to_string(user % config.companies));
+                resting.push_back(orderId);
+                events.push_back({WorkloadEvent::Type::Add, std::move(order), std::move(orderId)});
+            }
+            return events;
+        }
+
+        // Writes the events one per line: "A,orderId,securityId,side,qty,user,company" or "C,orderId".
+        static bool save(const std::string& path, const std::vector<WorkloadEvent>& events) {
+            std::ofstream out(path);
+            for (const auto& event : events) {
+                if (event.type == WorkloadEvent::Type::Add) {
+                    const auto& o = event.order;
+                    out << "A," << o.orderId() << ',' << o.securityId() << ',' << o.side() << ','
+                        << o.qty() << ',' << o.user() << ',' << o.company() << '\n';
+                } else {
+                    out << "C," << event.orderId << '\n';
+                }
+            }
+            return static_cast<bool>(out);
+        }
+
+        // Reads events written by save(); malformed lines are skipped.
+        static std::vector<WorkloadEvent> load(const std::string& path) {
+            std::vector<WorkloadEvent> events;
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::vector<std::string> fields;
+                std::stringstream stream(line);
+                std::string field;
+                while (std::getline(stream, field, ',')) {
+                    fields.push_back(field);
+                }
+                if (fields.size() == 7 && fields[0] == "A") {
+                    char* end = nullptr;
+                    unsigned long qty = std::strtoul(fields[4].c_str(), &end, 10);
+                    if (fields[4].empty() || *end != '\0') {
+                        continue;
+                    }
+                    Order order(fields[1], fields[2], fields[3], static_cast<unsigned int>(qty), fields[5], fields[6]);
+                    events.push_back({WorkloadEvent::Type::Add, std::move(order), fields[1]});
+                } else if (fields.size() == 2 && fields[0] == "C") {
+                    events.push_back({WorkloadEvent::Type::Cancel, Order(), fields[1]});
+                }
+            }
+            return events;
+        }
+
+    private:
+        WorkloadConfig config;
+};
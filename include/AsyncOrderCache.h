@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../OrderCacheInterface.cpp" // Make sure this header includes the OrderCacheInterface definition.
+#include "OrderBook.h"
+#include "MpscRing.h"
+#include "CacheStats.h"
+
+struct AsyncOrderCacheOptions {
+    // Commands the ring holds before producers have to wait for the applier.
+    std::size_t capacity = 1 << 16;
+
+    // Empty polls the applier spins through before it starts sleeping between polls.
+    unsigned idleSpins = 4096;
+
+    // How long the idle applier sleeps between polls.
+    std::chrono::microseconds idleSleep{50};
+};
+
+// Order cache front end for many concurrent producers and no shared lock.
+//
+// Mutations are not applied by the calling thread: they are copied into a lock-free
+// multi-producer ring and return at once. A single applier thread owns the OrderBook,
+// takes the commands in ring order and applies them without any locking. Queries are
+// commands too: they run on the applier after everything submitted before them, so a
+// query always sees the caller's own earlier submissions, and its caller waits for the answer.
+//
+// A full ring makes producers wait for the applier instead of dropping commands.
+class AsyncOrderCache : public OrderCacheInterface {
+
+    public:
+        explicit AsyncOrderCache(AsyncOrderCacheOptions options = {});
+
+        // Applies whatever is still queued, then stops the applier.
+        // No other thread may use the cache once destruction has begun.
+        ~AsyncOrderCache() override;
+
+        AsyncOrderCache(const AsyncOrderCache&) = delete;
+        AsyncOrderCache& operator=(const AsyncOrderCache&) = delete;
+
+        // Queues the order; an order with the same ID replaces the resting one when applied.
+        void addOrder(Order order) override;
+
+        // Queues the cancel of one order.
+        void cancelOrder(const std::string& orderId) override;
+
+        // Queues the batch as one command, applied through OrderBook::addOrders; later orders
+        // in the batch win over earlier ones with the same ID.
+        void addOrders(std::vector<Order> orders);
+
+        // Queues the cancel of each order. The ring takes no lock, so there is nothing to batch.
+        void cancelOrders(const std::vector<std::string>& orderIds);
+
+        // Queues the cancel of all orders of the user.
+        void cancelOrdersForUser(const std::string& user) override;
+
+        // Queues the cancel of the security's orders with qty >= minQty.
+        void cancelOrdersForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) override;
+
+        // Returns the matching size of the security once all earlier submissions are applied.
+        unsigned int getMatchingSizeForSecurity(const std::string& securityId) override;
+
+        // Returns the number and total qty of the security's orders with qty >= minQty
+        // once all earlier submissions are applied.
+        QtyTotals getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) const;
+
+        // Returns all orders sorted by order ID once all earlier submissions are applied.
+        // The applier only copies them; the sort runs on the calling thread.
+        std::vector<Order> getAllOrders() const override;
+
+        // Preallocates storage for the expected peak order count. Waits until the applier has done it.
+        void reserve(std::size_t expectedOrders);
+
+        // Barrier: blocks until every command submitted before the call, by any thread, is applied.
+        void flush() const;
+
+        // Runs function(const OrderBook&) on the applier after all earlier submissions and
+        // returns its result. The function must not call back into the cache.
+        template <class Function>
+        auto query(Function&& function) const;
+
+        // Starts or stops timing every operation on the calling thread: a mutation until it is
+        // queued, a query until its answer is back. The wait histograms record the time spent
+        // waiting for room in a full ring. While disabled an operation pays one atomic load.
+        void setStatsEnabled(bool enabled);
+
+        // Operation histograms (if stats were ever enabled), order/user/security counts and
+        // hash table occupancy, taken on the applier after all earlier submissions.
+        CacheStatsSnapshot statsSnapshot() const;
+
+        // Times a producer found the ring full and had to wait.
+        std::uint64_t producerStalls() const { return stalls.load(std::memory_order_relaxed); }
+
+        // Queued mutations that threw on the applier (e.g. std::bad_alloc) and were skipped.
+        // The book keeps whatever state the failed mutation left behind.
+        std::uint64_t failedMutations() const { return failures.load(std::memory_order_relaxed); }
+
+    private:
+        // Work run on the applier on behalf of a waiting caller, which owns the task.
+        struct Task {
+            virtual ~Task() = default;
+            virtual void run(OrderBook& book) = 0;
+
+            std::atomic<bool> done{false};
+            std::exception_ptr error;
+        };
+
+        enum class CommandType : std::uint8_t {
+            Add,
+            AddBatch,
+            Cancel,
+            CancelForUser,
+            CancelForSecIdWithMinimumQty,
+            Run,
+        };
+
+        struct Command {
+            CommandType type = CommandType::Add;
+            Order order;              // Add
+            std::vector<Order> batch; // AddBatch
+            std::string key;          // order ID, user or security ID of the cancels
+            unsigned int minQty = 0;  // CancelForSecIdWithMinimumQty
+            Task* task = nullptr;     // Run
+        };
+
+        AsyncOrderCacheOptions options;
+
+        // Orders and their indexes; touched by the applier thread only.
+        OrderBook book;
+
+        // Commands from any thread to the applier. Queries enqueue too, hence mutable.
+        mutable MpscRing<Command> commands;
+
+        // Producer waits on a full ring, see producerStalls().
+        mutable std::atomic<std::uint64_t> stalls{0};
+
+        // Mutations that threw on the applier, see failedMutations().
+        std::atomic<std::uint64_t> failures{0};
+        // Operation histograms, created on first enable and never replaced afterwards,
+        // so operations can use them without a lock once statsEnabled is seen set.
+        std::unique_ptr<CacheStats> stats;
+        std::atomic<bool> statsEnabled{false};
+
+        // Serializes setStatsEnabled against itself and statsSnapshot.
+        mutable std::mutex statsMutex;
+
+        std::atomic<bool> stopping{false};
+        std::thread applier;
+
+        // Moves the command into the ring, waiting while the ring is full. Everything that can
+        // throw happens while the caller builds the command, before a ring cell is claimed.
+        void submit(Command&& command) const;
+
+        // Queues the task and waits until the applier has run it, rethrowing what it threw.
+        // The timer, if any, is marked locked once the task is in the ring.
+        void execute(Task& task, OpTimer* timer = nullptr) const;
+
+        // query() on behalf of a timed operation.
+        template <class Function>
+        auto timedQuery(OpTimer* timer, Function&& function) const;
+
+        // Histograms to record into, or null while stats are disabled.
+        CacheStats* activeStats() const {
+            return statsEnabled.load(std::memory_order_acquire) ? stats.get() : nullptr;
+        }
+
+        // Applier thread body: applies commands until stopped and the ring is empty.
+        void apply();
+};
+
+template <class Function>
+auto AsyncOrderCache::query(Function&& function) const {
+    return timedQuery(nullptr, std::forward<Function>(function));
+}
+
+template <class Function>
+auto AsyncOrderCache::timedQuery(OpTimer* timer, Function&& function) const {
+    using Result = decltype(function(std::declval<const OrderBook&>()));
+
+    struct QueryTask : Task {
+        explicit QueryTask(Function& function) : function(function) {}
+
+        void run(OrderBook& book) override { result.emplace(function(std::as_const(book))); }
+
+        Function& function;
+        std::optional<Result> result;
+    };
+
+    QueryTask task(function);
+    execute(task, timer);
+    return std::move(*task.result);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Occupancy of one hash table, for spotting bad hashing or an undersized reserve().
+struct HashTableStats {
+    std::string name;
+    std::size_t entries = 0;
+    std::size_t buckets = 0;
+    float loadFactor = 0;
+    float maxLoadFactor = 0;
+    std::size_t usedBuckets = 0;       // buckets holding at least one entry
+    std::size_t collidedEntries = 0;   // entries sharing a bucket with an earlier one
+    std::size_t longestChain = 0;      // entries in the fullest bucket
+
+    // Measures any std::unordered_map-like container. Walks every bucket, so it costs O(buckets).
+    template <class Map>
+    static HashTableStats measure(std::string name, const Map& map) {
+        HashTableStats stats;
+        stats.name = std::move(name);
+        stats.entries = map.size();
+        stats.buckets = map.bucket_count();
+        stats.loadFactor = map.load_factor();
+        stats.maxLoadFactor = map.max_load_factor();
+        for (std::size_t bucket = 0; bucket < stats.buckets; ++bucket) {
+            std::size_t chain = map.bucket_size(bucket);
+            if (chain > 0) {
+                ++stats.usedBuckets;
+                stats.collidedEntries += chain - 1;
+                stats.longestChain = std::max(stats.longestChain, chain);
+            }
+        }
+        return stats;
+    }
+
+    // Folds in the same table of another book, e.g. another shard of one cache.
+    void add(const HashTableStats& other) {
+        entries += other.entries;
+        buckets += other.buckets;
+        loadFactor = buckets ? static_cast<float>(entries) / buckets : 0;
+        maxLoadFactor = std::max(maxLoadFactor, other.maxLoadFactor);
+        usedBuckets += other.usedBuckets;
+        collidedEntries += other.collidedEntries;
+        longestChain = std::max(longestChain, other.longestChain);
+    }
+};
+
+// Size of an order book's contents and indexes at one point in time.
+struct BookStats {
+    std::size_t orders = 0;
+    std::size_t users = 0;        // users with at least one resting order
+    std::size_t securities = 0;   // securities with at least one resting order
+    std::size_t companies = 0;    // companies ever seen
+    std::size_t recordSlots = 0;  // record capacity, used or free
+    std::vector<HashTableStats> tables;
+
+    // Adds another book's counts and tables, to total the shards of one cache.
+    // A user or company present in several books is counted once per book.
+    void add(const BookStats& other) {
+        orders += other.orders;
+        users += other.users;
+        securities += other.securities;
+        companies += other.companies;
+        recordSlots += other.recordSlots;
+        for (const auto& table : other.tables) {
+            auto same = std::find_if(tables.begin(), tables.end(), [&](const HashTableStats& mine) {
+                return mine.name == table.name;
+            });
+            if (same == tables.end()) {
+                tables.push_back(table);
+            } else {
+                same->add(table);
+            }
+        }
+    }
+};
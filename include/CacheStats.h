@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BookStats.h"
+
+// Operations of OrderCacheInterface that the cache times.
+enum class CacheOp {
+    AddOrder,
+    AddOrders,
+    CancelOrder,
+    CancelOrders,
+    CancelOrdersForUser,
+    CancelOrdersForSecIdWithMinimumQty,
+    GetMatchingSizeForSecurity,
+    GetMatchingSizeForAllSecurities,
+    GetAllOrders,
+    Count
+};
+
+// Name of the operation as it appears in dumps, e.g. "addOrder".
+const char* cacheOpName(CacheOp op);
+
+// Percentiles and extremes of one latency distribution, in nanoseconds.
+struct LatencySummary {
+    std::uint64_t count = 0;
+    std::uint64_t totalNs = 0;
+    std::uint64_t minNs = 0;
+    std::uint64_t p50Ns = 0;
+    std::uint64_t p90Ns = 0;
+    std::uint64_t p99Ns = 0;
+    std::uint64_t p999Ns = 0;
+    std::uint64_t maxNs = 0;
+
+    double meanNs() const { return count ? static_cast<double>(totalNs) / count : 0.0; }
+};
+
+// HDR-style latency histogram: buckets are linear within each power of two and split it
+// 32 ways, so any recorded value is reported within ~3% over a range of 1ns to ~18 minutes
+// (longer values are clamped). Recording is a few relaxed atomic adds, safe from any thread.
+class LatencyHistogram {
+
+    public:
+        static constexpr unsigned subBucketBits = 5;
+        static constexpr unsigned maxValueBits = 40;
+        static constexpr std::size_t bucketCount =
+            (maxValueBits - subBucketBits + 1) << subBucketBits;
+
+        void record(std::uint64_t ns);
+
+        // Summarizes what was recorded so far; concurrent records may or may not be included.
+        LatencySummary summary() const;
+
+    private:
+        std::array<std::atomic<std::uint64_t>, bucketCount> counts{};
+        std::atomic<std::uint64_t> total{0};
+        std::atomic<std::uint64_t> minimum{UINT64_MAX};
+        std::atomic<std::uint64_t> maximum{0};
+
+        static std::size_t bucketOf(std::uint64_t ns);
+
+        // Highest value that falls into the bucket.
+        static std::uint64_t bucketUpperBound(std::size_t bucket);
+};
+
+// Latency and lock-wait figures of one operation.
+struct OperationStats {
+    std::string name;
+    LatencySummary latency;    // call to return, lock wait included
+    LatencySummary lockWait;   // time spent acquiring the cache's locks, or waiting for ring room
+};
+
+// Everything the cache can tell about itself at one point in time.
+struct CacheStatsSnapshot {
+    std::vector<OperationStats> operations;
+    BookStats book;
+
+    // Human-readable table.
+    std::string toText() const;
+
+    // One JSON object, for scraping.
+    std::string toJson() const;
+};
+
+// Latency and lock-wait histograms for every operation of a cache.
+class CacheStats {
+
+    public:
+        void recordLatency(CacheOp op, std::uint64_t ns) { latency[static_cast<std::size_t>(op)].record(ns); }
+        void recordLockWait(CacheOp op, std::uint64_t ns) { lockWait[static_cast<std::size_t>(op)].record(ns); }
+
+        // Operations that were called at least once.
+        std::vector<OperationStats> operations() const;
+
+    private:
+        static constexpr std::size_t opCount = static_cast<std::size_t>(CacheOp::Count);
+
+        std::array<LatencyHistogram, opCount> latency;
+        std::array<LatencyHistogram, opCount> lockWait;
+};
+
+// Times one operation from construction to destruction, with locked() marking the moment
+// the cache lock was acquired. Does nothing, not even read the clock, when 'stats' is null.
+class OpTimer {
+
+    public:
+        OpTimer(CacheStats* stats, CacheOp op) : stats(stats), op(op) {
+            if (stats) {
+                start = Clock::now();
+            }
+        }
+
+        ~OpTimer() {
+            if (stats) {
+                stats->recordLatency(op, elapsedSince(start));
+            }
+        }
+
+        OpTimer(const OpTimer&) = delete;
+        OpTimer& operator=(const OpTimer&) = delete;
+
+        void locked() {
+            if (stats) {
+                stats->recordLockWait(op, elapsedSince(start));
+            }
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        CacheStats* stats;
+        CacheOp op;
+        Clock::time_point start;
+
+        static std::uint64_t elapsedSince(Clock::time_point start) {
+            return static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        }
+};
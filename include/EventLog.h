@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "MpscRing.h"
+
+// Builds without ORDERCACHE_EVENT_LOG (see the CMake option of the same name) compile every
+// ORDERCACHE_LOG_EVENT away, so the caches pay nothing for the log, not even a branch.
+#if ORDERCACHE_EVENT_LOG
+#define ORDERCACHE_LOG_EVENT(log, ...) \
+    do { \
+        if (log) { \
+            (log)->record(__VA_ARGS__); \
+        } \
+    } while (0)
+#else
+// Arguments stay unevaluated; sizeof only keeps them "used" for the compiler's warnings.
+#define ORDERCACHE_LOG_EVENT(log, ...) \
+    do { \
+        (void)sizeof(((log), __VA_ARGS__, 0)); \
+    } while (0)
+#endif
+
+// What happened to the cache.
+enum class EventType : std::uint8_t {
+    Add = 1,                           // key = order ID, qty = order qty
+    Cancel = 2,                        // key = order ID
+    CancelForUser = 3,                 // key = user, result = orders cancelled
+    CancelForSecIdWithMinimumQty = 4,  // qty = minQty, result = orders cancelled
+    Match = 5,                         // result = matching size
+};
+
+// One fixed-size log entry. Strings longer than their field are truncated.
+struct Event {
+    std::int64_t timestampNs = 0;      // system clock, nanoseconds since the epoch
+    EventType type = EventType::Add;
+    char side[7] = {};
+    std::uint32_t qty = 0;
+    std::uint32_t result = 0;
+    char key[48] = {};
+    char securityId[32] = {};
+};
+
+// How the drain thread writes events.
+enum class EventLogFormat {
+    Text,    // one line per event: timestamp,type,key,securityId,side,qty,result
+    Binary,  // "OCEVLOG1" followed by raw Event structs in native layout
+};
+
+struct EventLogOptions {
+    EventLogFormat format = EventLogFormat::Text;
+
+    // Events the ring holds before recording starts to drop them.
+    std::size_t capacity = 1 << 16;
+
+    // How long the drain thread sleeps when it finds the ring empty.
+    std::chrono::microseconds drainInterval{1000};
+};
+
+// Structured event log for the caches. record() copies the event into a lock-free ring and
+// returns; a background thread drains the ring into the file. Recording never blocks and
+// never does I/O: when the ring is full the event is dropped and counted instead.
+class EventLog {
+
+    public:
+        // Opens (truncates) the file and starts the drain thread.
+        // Throws std::runtime_error if the file cannot be opened.
+        explicit EventLog(const std::string& path, EventLogOptions options = {});
+
+        // Drains whatever is still queued, then stops the thread and closes the file.
+        ~EventLog();
+
+        EventLog(const EventLog&) = delete;
+        EventLog& operator=(const EventLog&) = delete;
+
+        // Queues an event. Safe from any number of threads at once.
+        void record(EventType type, const std::string& key, const std::string& securityId = std::string(),
+                    const std::string& side = std::string(), std::uint32_t qty = 0, std::uint32_t result = 0);
+
+        // Blocks until every event recorded before the call has been written to the file.
+        void flush();
+
+        // Events lost because the ring was full.
+        std::uint64_t droppedEvents() const { return dropped.load(std::memory_order_relaxed); }
+
+    private:
+        EventLogOptions options;
+        std::FILE* file = nullptr;
+        MpscRing<Event> ring;
+
+        std::atomic<std::uint64_t> dropped{0};
+
+        // Events written to the file, which is also the ring position the drain has reached.
+        std::atomic<std::uint64_t> written{0};
+        std::atomic<bool> stopping{false};
+        std::thread drainThread;
+
+        // Drain thread body: writes events until stopped and the ring is empty.
+        void drain();
+
+        // Writes one event in the configured format.
+        void write(const Event& event);
+};
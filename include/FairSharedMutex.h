@@ -0,0 +1,48 @@
+#pragma once
+
+#include <mutex> // For std::mutex
+#include <shared_mutex> // For std::shared_mutex
+
+// Reader/writer lock that does not let a stream of readers starve writers.
+// Meets the SharedMutex requirements, so it works with std::unique_lock and std::shared_lock.
+//
+// std::shared_mutex on glibc prefers readers: while any reader holds the lock new readers
+// keep getting in, and a writer can wait indefinitely. Here a waiting writer holds the
+// turnstile, which new readers must pass through, so it only waits for the readers
+// already inside.
+class FairSharedMutex {
+
+    public:
+        void lock() {
+            std::lock_guard<std::mutex> gate(turnstile);
+            rw.lock();
+        }
+
+        bool try_lock() {
+            std::unique_lock<std::mutex> gate(turnstile, std::try_to_lock);
+            return gate.owns_lock() && rw.try_lock();
+        }
+
+        void unlock() { rw.unlock(); }
+
+        void lock_shared() {
+            {
+                std::lock_guard<std::mutex> gate(turnstile);
+            }
+            rw.lock_shared();
+        }
+
+        bool try_lock_shared() {
+            std::unique_lock<std::mutex> gate(turnstile, std::try_to_lock);
+            return gate.owns_lock() && rw.try_lock_shared();
+        }
+
+        void unlock_shared() { rw.unlock_shared(); }
+
+    private:
+        // Held by a writer while it waits for the readers inside to leave.
+        std::mutex turnstile;
+
+        // The actual reader/writer lock.
+        std::shared_mutex rw;
+};
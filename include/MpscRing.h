@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Bounded lock-free queue for many producers and one consumer.
+//
+// Each cell carries a sequence number telling whose turn it is: producers claim a
+// position with one CAS on the enqueue counter and publish the value by bumping the
+// cell's sequence; the consumer waits for that bump, takes the value and hands the
+// cell back to producers one lap later. Neither side ever blocks; a full ring makes
+// tryPush fail instead, so the caller decides whether to drop, retry or back off.
+template <class T>
+class MpscRing {
+
+    public:
+        // Capacity is rounded up to a power of two (at least 2).
+        explicit MpscRing(std::size_t capacity) {
+            std::size_t size = 2;
+            while (size < capacity) {
+                size *= 2;
+            }
+            mask = size - 1;
+            cells = std::make_unique<Cell[]>(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing&) = delete;
+        MpscRing& operator=(const MpscRing&) = delete;
+
+        std::size_t capacity() const { return mask + 1; }
+
+        // Positions producers have claimed so far, including values still being written.
+        // The consumer pops them in this order. Safe from any thread.
+        std::size_t claimed() const { return enqueuePosition.load(std::memory_order_acquire); }
+
+        // Enqueues the value; returns false, leaving the value untouched, if the ring is full.
+        // Assigning it must not throw, see tryPushWith. Safe from any thread.
+        template <class U>
+        bool tryPush(U&& value) {
+            return tryPushWith([&value](T& cell) noexcept(std::is_nothrow_assignable<T&, U&&>::value) {
+                cell = std::forward<U>(value);
+            });
+        }
+
+        // Like tryPush, but fill(T&) writes the value straight into the claimed cell.
+        // fill must be noexcept: a claimed cell has to be published, or the consumer would
+        // wait on it forever. Safe from any thread.
+        template <class Fill>
+        bool tryPushWith(Fill&& fill) {
+            static_assert(noexcept(fill(std::declval<T&>())), "fill runs on a claimed cell and must not throw");
+            std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[position & mask];
+                std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+                if (lag == 0) {
+                    // The cell is free for this lap; claim the position
+                    if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        fill(cell.value);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (lag < 0) {
+                    // The consumer has not freed the cell from the previous lap
+                    return false;
+                } else {
+                    position = enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Dequeues the oldest value; returns false if the ring is empty. Consumer thread only.
+        bool tryPop(T& value) {
+            Cell& cell = cells[dequeuePosition & mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence != dequeuePosition + 1) {
+                return false;
+            }
+            value = std::move(cell.value);
+            cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+            ++dequeuePosition;
+            return true;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence{0};
+            T value{};
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        std::size_t mask = 0;
+
+        // Producers and the consumer write different counters; keep them on different cache lines.
+        alignas(64) std::atomic<std::size_t> enqueuePosition{0};
+        alignas(64) std::size_t dequeuePosition = 0;
+};
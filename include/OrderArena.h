@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Free-list arena for the small, equally sized allocations an order book churns through:
+// hash map nodes, per-company totals and long order ID strings.
+//
+// Requests up to maxBlockSize bytes are rounded up to a multiple of 'granularity' and
+// served from per-size free lists, refilled by carving large chunks obtained from the
+// upstream resource. Freed blocks go back to their free list and are never returned
+// upstream, so a steady add/cancel churn stops calling malloc once the peak is reached.
+// Larger requests (bucket arrays, vector storage) are passed straight upstream.
+//
+// Not thread-safe by default: the arena belongs to one OrderBook and is used under the book's
+// lock. setShared(true) serializes it for the book's parallel phases.
+class OrderArena : public std::pmr::memory_resource {
+
+    public:
+        static constexpr std::size_t granularity = 16;
+        static constexpr std::size_t maxBlockSize = 512;
+
+        explicit OrderArena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+        ~OrderArena() override;
+
+        OrderArena(const OrderArena&) = delete;
+        OrderArena& operator=(const OrderArena&) = delete;
+
+        // Makes sure at least 'bytes' more bytes can be carved without asking upstream.
+        void reserve(std::size_t bytes);
+
+        // While set, allocations and deallocations take a lock and may come from several threads at once.
+        // Must not be switched while another thread uses the arena.
+        void setShared(bool isShared) { shared = isShared; }
+
+        // Total bytes obtained from upstream for chunks.
+        std::size_t bytesReserved() const { return reservedBytes; }
+
+    private:
+        static constexpr std::size_t classCount = maxBlockSize / granularity;
+        static constexpr std::size_t minChunkSize = 64 * 1024;
+        static constexpr std::size_t maxChunkSize = 4 * 1024 * 1024;
+
+        // Header written into a freed block to link it into its free list.
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        // Free list heads, one per size class.
+        FreeBlock* freeLists[classCount] = {};
+
+        // Unused tail of the current chunk.
+        std::byte* cursor = nullptr;
+        std::byte* chunkEnd = nullptr;
+
+        // Chunks obtained from upstream, released on destruction.
+        std::vector<std::pair<void*, std::size_t>> chunks;
+        std::size_t nextChunkSize = minChunkSize;
+        std::size_t reservedBytes = 0;
+
+        std::pmr::memory_resource* upstream;
+
+        // Serializes the arena while 'shared' is set.
+        bool shared = false;
+        std::mutex mutex;
+
+        // Obtains a new chunk of at least 'bytes' bytes from upstream and makes it current.
+        void addChunk(std::size_t bytes);
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <unordered_map>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <memory_resource>
+
+#include "../Order.cpp"
+#include "SymbolTable.h"
+#include "OrderArena.h"
+#include "QtyKernels.h"
+#include "BookStats.h"
+#include "OrderIdIndex.h"
+#include "WorkStealingPool.h"
+
+// Compact handle addressing an order's slot in the book's record storage.
+using OrderHandle = std::uint32_t;
+
+// Marks the end of an intrusive order list.
+constexpr OrderHandle invalidHandle = static_cast<OrderHandle>(-1);
+
+// Read-only view of a resting order handed to visitors, without copying any string.
+// The views point into the book and are valid only for the duration of the visitor call.
+struct OrderView {
+    std::string_view orderId;
+    std::string_view securityId;
+    std::string_view side;
+    std::string_view user;
+    std::string_view company;
+    unsigned int qty;
+
+    // Materializes an Order for callers that need to keep it.
+    Order toOrder() const {
+        return Order(std::string(orderId), std::string(securityId), std::string(side), qty,
+                     std::string(user), std::string(company));
+    }
+};
+
+// Matching size of one security, as reported for all securities at once.
+struct SecurityMatch {
+    std::string securityId;
+    unsigned int matchingSize = 0;
+
+    bool operator==(const SecurityMatch& other) const {
+        return securityId == other.securityId && matchingSize == other.matchingSize;
+    }
+};
+
+// Unsynchronized order storage and indexes behind the cache front ends.
+// OrderCache guards a single book with one mutex; ShardedOrderCache partitions
+// orders by security over several books, each with its own lock.
+class OrderBook {
+
+    public:
+        // Index nodes and order IDs come from a per-book arena fed by 'upstream'.
+        explicit OrderBook(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+        // Preallocates record slots, hash buckets and arena memory for the expected peak order count.
+        void reserve(std::size_t expectedOrders);
+
+        // Number of orders the book can hold before record storage has to grow.
+        std::size_t capacity() const { return records.size(); }
+
+        // Adds a new order; an order with the same ID replaces the resting one.
+        void addOrder(const Order& order);
+
+        // Adds a batch of orders; later orders win over earlier ones with the same ID.
+        // The index grows once for the whole batch, and the orders are linked into the
+        // per-security and per-user indexes grouped by security and by user.
+        // The book holds the same orders and answers every query as after adding them one by one;
+        // only the row order of a security's columns may differ.
+        void addOrders(const std::vector<Order>& batch);
+
+        // Removes the order with this ID. Returns false if there was no such order.
+        bool cancelOrder(const std::string& orderId);
+
+        // Removes all orders of the user and returns how many were removed.
+        // The IDs of the removed orders are appended to cancelledIds when it is given.
+        // With a pool, a user with many orders is cancelled security by security in parallel;
+        // the book ends up exactly as after the serial cancel.
+        std::size_t cancelOrdersForUser(const std::string& user, std::vector<std::string>* cancelledIds = nullptr,
+                                        WorkStealingPool* pool = nullptr);
+
+        // Removes all orders of the security with qty >= minQty and returns how many were removed.
+        // The IDs of the removed orders are appended to cancelledIds when it is given.
+        std::size_t cancelOrdersForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty,
+                                                       std::vector<std::string>* cancelledIds = nullptr);
+
+        // Returns the total qty that can match between buys and sells of different companies.
+        unsigned int getMatchingSizeForSecurity(const std::string& securityId) const;
+
+        // Returns the matching size of every security with resting orders, sorted by security ID.
+        // With a pool the securities are split across its threads.
+        std::vector<SecurityMatch> getMatchingSizeForAllSecurities(WorkStealingPool* pool = nullptr) const;
+
+        // Returns the number and total qty of the security's orders with qty >= minQty,
+        // i.e. what cancelOrdersForSecIdWithMinimumQty would remove, without removing anything.
+        QtyTotals getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) const;
+
+        // Appends copies of all resting orders to 'out', in no particular order.
+        void appendOrders(std::vector<Order>& out) const;
+
+        // Calls visit(const OrderView&) for every resting order, in no particular order.
+        template <class Visitor>
+        void visitOrders(Visitor&& visit) const;
+
+        // Calls visit(const OrderView&) for every resting order of the security.
+        template <class Visitor>
+        void visitOrdersForSecurity(const std::string& securityId, Visitor&& visit) const;
+
+        // Calls visit(const OrderView&) for every resting order of the user.
+        template <class Visitor>
+        void visitOrdersForUser(const std::string& user, Visitor&& visit) const;
+
+        // Calls visit(const OrderView&) for every resting order in ascending order ID.
+        // Walks the ordered view when it is maintained, otherwise sorts handles (not orders) first.
+        template <class Visitor>
+        void visitOrdersById(Visitor&& visit) const;
+
+        // Starts or stops maintaining the ordered-by-orderId view incrementally.
+        // Enabling it builds the view from the resting orders once; afterwards every add
+        // and cancel pays an O(log n) update so that sorted dumps need no sort at all.
+        void setOrderedViewEnabled(bool enabled);
+        bool orderedViewEnabled() const { return orderedView; }
+
+        // Returns true if an order with this ID is resting in the book.
+        bool contains(const std::string& orderId) const;
+
+        // Number of resting orders.
+        std::size_t size() const { return orders.size(); }
+
+        // Counts of orders, users and securities, and the occupancy of the hash tables.
+        // Walks the per-symbol indexes and every hash bucket, so it is meant for monitoring.
+        BookStats stats() const;
+
+    private:
+        // Compact internal representation of a resting order.
+        // Everything except the order ID is stored as an interned symbol, so each
+        // distinct user, company, security and side string lives only once in the cache.
+        struct OrderRecord {
+            explicit OrderRecord(std::pmr::memory_resource* resource) : orderId(resource) {}
+
+            std::pmr::string orderId;
+            // OrderIdIndex::hash(orderId), kept so the index can drop the order without rehashing the ID.
+            std::uint64_t idHash = 0;
+            SymbolId securityId = 0;
+            SymbolId side = 0;
+            SymbolId user = 0;
+            SymbolId company = 0;
+            std::uint32_t qty = 0;
+
+            // Row of the order in its security's columns.
+            // While addOrders has yet to link the order, its position in the batch instead.
+            std::uint32_t securityRow = 0;
+
+            // Links of the intrusive per-user order list.
+            OrderHandle userPrev = invalidHandle;
+            OrderHandle userNext = invalidHandle;
+
+            // Links of the intrusive list of same-qty orders in the security's qty index.
+            OrderHandle qtyPrev = invalidHandle;
+            OrderHandle qtyNext = invalidHandle;
+        };
+
+        // Head of an intrusive doubly linked list of order records.
+        struct OrderList {
+            OrderHandle head = invalidHandle;
+            std::size_t size = 0;
+        };
+
+        // Arena backing the containers below; declared first so it outlives them.
+        OrderArena arena;
+
+        // Slot storage for order records, addressed by OrderHandle.
+        // A deque keeps records at stable addresses, which lets 'ordersById' key on views of their IDs.
+        // Released slots keep their string capacity, so reusing one rarely allocates.
+        std::pmr::deque<OrderRecord> records;
+
+        // Handles of released slots in 'records', reused before the deque grows.
+        std::vector<OrderHandle> freeHandles;
+
+        // Maps each order's unique ID to the handle of its record for quick retrieval and management.
+        // The index stores only handles and hashes; keys are compared against the IDs in the records.
+        // Its tables are allocated directly rather than from the arena, so they start as zeroed pages.
+        OrderIdIndex orders;
+
+        // Order IDs in ascending order, kept up to date only while 'orderedView' is set.
+        std::pmr::map<std::string_view, OrderHandle> ordersById;
+        bool orderedView = false;
+
+        // Interning tables for the string fields shared between many orders.
+        SymbolTable users;
+        SymbolTable companies;
+        SymbolTable securities;
+        SymbolTable sides;
+
+        // Per-security totals from which the matching size is derived.
+        // The resting buy and sell quantity of each company sit in packed columns, so the
+        // matching query is one vectorized pass over them. Companies without resting quantity
+        // are swap-removed, so queries cost O(#companies in the security).
+        struct MatchingAggregate {
+            explicit MatchingAggregate(std::pmr::memory_resource* resource) : companyRow(resource) {}
+
+            std::uint64_t totalBuy = 0;
+            std::uint64_t totalSell = 0;
+
+            // Row of each company in the columns below.
+            std::pmr::unordered_map<SymbolId, std::uint32_t> companyRow;
+            std::vector<SymbolId> company;
+            std::vector<std::uint64_t> buy;
+            std::vector<std::uint64_t> sell;
+        };
+
+        // Lists of the orders placed by each user, indexed by the user's SymbolId.
+        // The links live in the records themselves, so an order is unlinked in O(1).
+        std::vector<OrderList> userOrders;
+
+        // Orders of one security as parallel columns, one row per order.
+        // Rows stay packed (a cancel moves the last row into the hole), so the min-qty scan
+        // reads a contiguous qty array instead of chasing records. Only what a scan or a cancel
+        // reads is kept; users and companies stay in the records.
+        // The columns keep their capacity when orders leave, so churn does not reallocate them.
+        struct SecurityColumns {
+            std::vector<std::uint32_t> qty;
+            std::vector<OrderSide> side;
+            std::vector<OrderHandle> handle;
+
+            std::size_t size() const { return handle.size(); }
+        };
+
+        // Columns of each security, indexed by the security's SymbolId.
+        std::vector<SecurityColumns> securityColumns;
+
+        // Matching totals for each security, indexed by the security's SymbolId.
+        std::vector<MatchingAggregate> securityAggregates;
+
+        // Orders of one security grouped by qty, in ascending qty. Each level lists its orders
+        // intrusively, and levels are dropped once empty, so a "qty >= N" walk starts at
+        // lower_bound(N) and touches only the qualifying orders.
+        using QtyLevels = std::pmr::map<unsigned int, OrderList>;
+
+        // Qty index of each security, indexed by the security's SymbolId.
+        std::vector<QtyLevels> securityQtyLevels;
+
+        // Side symbols that take part in matching; other sides are stored but never match.
+        SymbolId buySide;
+        SymbolId sellSide;
+
+        // Column reductions for this CPU.
+        const QtyKernels& kernels;
+
+        // Maps an interned side to the side the columns store.
+        OrderSide sideOf(SymbolId side) const {
+            return side == buySide ? OrderSide::Buy : side == sellSide ? OrderSide::Sell : OrderSide::Other;
+        }
+
+        // Stores the order in a free record slot and returns its handle.
+        OrderHandle allocateRecord(const Order& order);
+
+        // Returns the handle of the order with this ID, or invalidHandle.
+        OrderHandle findOrder(const std::string& orderId) const;
+
+        // Removes the order behind the handle from 'orders' and returns its slot to the free list.
+        void releaseRecord(OrderHandle handle);
+
+        // Rebuilds a public Order object from its internal record.
+        Order toOrder(const OrderRecord& record) const;
+
+        // Returns a view of the record's fields.
+        OrderView view(const OrderRecord& record) const {
+            return {record.orderId, securities.name(record.securityId), sides.name(record.side),
+                    users.name(record.user), companies.name(record.company), record.qty};
+        }
+
+        // Updates internal mappings (userOrders and securityColumns) when a new order is added.
+        // Ensures that orders can be efficiently accessed by both user and security ID.
+        void updateMappingsOnAdd(OrderHandle handle);
+
+        // Sizes the per-user and per-security indexes for the given symbols.
+        void growSymbolIndexes(SymbolId user, SymbolId secId);
+
+        // Pushes the order at the front of its user's list.
+        void linkToUser(OrderHandle handle);
+
+        // Appends the order to its security's columns and qty index and adds it to the matching totals.
+        void linkToSecurity(OrderHandle handle);
+
+        // Returns true once the order has a row in its security's columns.
+        bool isLinked(OrderHandle handle) const;
+
+        // Updates internal mappings when an order is removed.
+        // Unlinks the order from its user's list and its security's columns in constant time.
+        void updateMappingsOnCancel(OrderHandle handle);
+
+        // Removes the order from its security's columns and qty index only,
+        // used when the user's list is dropped wholesale.
+        void unlinkFromSecurity(OrderHandle handle);
+
+        // Returns the matching size of an interned security.
+        unsigned int matchingSizeOf(SymbolId secId) const;
+
+        // Unlinks the given orders from their securities, one pool job per security.
+        // Each security unlinks its share of 'handles' in the order given.
+        void unlinkFromSecuritiesInParallel(const std::vector<OrderHandle>& handles, WorkStealingPool& pool);
+
+        // Counts and sums the security's orders with qty >= minQty, walking the qty index
+        // or scanning the qty column, whichever touches less memory.
+        QtyTotals qtyTotalsAtLeast(SymbolId secId, unsigned int minQty) const;
+
+        // Adds the order's quantity to (or removes it from) its security's matching totals.
+        void addToAggregate(const OrderRecord& record, OrderSide side);
+        void removeFromAggregate(const OrderRecord& record, OrderSide side);
+};
+
+template <class Visitor>
+void OrderBook::visitOrders(Visitor&& visit) const {
+    orders.forEach([&](OrderHandle handle) { visit(view(records[handle])); });
+}
+
+template <class Visitor>
+void OrderBook::visitOrdersForSecurity(const std::string& securityId, Visitor&& visit) const {
+    SymbolId secId = securities.find(securityId);
+    if (secId == SymbolTable::npos) {
+        return;
+    }
+    for (OrderHandle handle : securityColumns[secId].handle) {
+        visit(view(records[handle]));
+    }
+}
+
+template <class Visitor>
+void OrderBook::visitOrdersForUser(const std::string& user, Visitor&& visit) const {
+    SymbolId userId = users.find(user);
+    if (userId == SymbolTable::npos) {
+        return;
+    }
+    for (OrderHandle handle = userOrders[userId].head; handle != invalidHandle; handle = records[handle].userNext) {
+        visit(view(records[handle]));
+    }
+}
+
+template <class Visitor>
+void OrderBook::visitOrdersById(Visitor&& visit) const {
+    if (orderedView) {
+        for (const auto& [orderId, handle] : ordersById) {
+            visit(view(records[handle]));
+        }
+        return;
+    }
+
+    std::vector<OrderHandle> handles;
+    handles.reserve(orders.size());
+    orders.forEach([&](OrderHandle handle) { handles.push_back(handle); });
+    std::sort(handles.begin(), handles.end(), [this](OrderHandle a, OrderHandle b) {
+        return records[a].orderId < records[b].orderId;
+    });
+    for (OrderHandle handle : handles) {
+        visit(view(records[handle]));
+    }
+}
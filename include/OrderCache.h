@@ -1,12 +1,18 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
 #include <string>
-#include <iostream>
-#include <mutex> // For std::mutex
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex> // For std::shared_lock
 
 #include "../OrderCacheInterface.cpp" // Make sure this header includes the OrderCacheInterface definition.
+#include "OrderBook.h"
+#include "FairSharedMutex.h"
+#include "OrderPersistence.h"
+#include "EventLog.h"
+#include "CacheStats.h"
 
 class OrderCache : public OrderCacheInterface {
 
@@ -15,6 +21,17 @@ class OrderCache : public OrderCacheInterface {
         OrderCache() = default;
         ~OrderCache() = default;
 
+        // Order records and index nodes are carved from an arena fed by 'upstream'
+        // (a thread-safe memory resource, e.g. a std::pmr::synchronized_pool_resource).
+        explicit OrderCache(std::pmr::memory_resource* upstream);
+
+        // Preallocates storage for the expected peak order count, so the cache does not
+        // touch the heap for order records or index nodes until that count is exceeded.
+        void reserve(std::size_t expectedOrders);
+
+        // Number of orders the cache can hold before its record storage has to grow.
+        std::size_t capacity() const;
+
         // Adds a new order to the cache.
         // Updates internal mappings for quick access based on user and security identifiers.
         void addOrder(Order order) override;
@@ -25,6 +42,7 @@ class OrderCache : public OrderCacheInterface {
 
         // Cancels all orders associated with a given user.
         // This method iterates through all orders for the specified user and removes them from the cache.
+        // With setParallelism(), a user with many orders is cancelled security by security in parallel.
         void cancelOrdersForUser(const std::string& user) override;
 
         // Cancels all orders associated with a specific security ID that have a quantity greater than or equal to the specified minimum.
@@ -33,32 +51,145 @@ class OrderCache : public OrderCacheInterface {
 
         // Returns the total matched quantity for orders with the specified security ID.
         // Orders match if they have the same security ID, different sides (buy/sell), and belong to different companies.
+        // Answered from per-company totals kept up to date on every add and cancel; the cache is not modified.
         unsigned int getMatchingSizeForSecurity(const std::string& securityId) override;
 
+        // Returns the matching size of every security with resting orders, sorted by security ID,
+        // under one shared lock. With setParallelism() the securities are split across the pool.
+        std::vector<SecurityMatch> getMatchingSizeForAllSecurities() const;
+
+        // Returns the number and total qty of the security's orders with qty >= minQty.
+        // Answered from the security's qty index in O(#distinct qty values >= minQty).
+        QtyTotals getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) const;
+
         // Retrieves all orders currently in the cache.
         // Returns a vector containing copies of all Order objects stored.
+        // The copy is taken under a shared lock and sorted after it is released.
         std::vector<Order> getAllOrders() const override;
 
+        // Streams every resting order to visit(const OrderView&) under a shared lock, without copying.
+        // The views are valid only during the call, and the visitor must not call back into the cache.
+        template <class Visitor>
+        void visitOrders(Visitor&& visit) const;
+
+        // Streams the resting orders of one security.
+        template <class Visitor>
+        void visitOrdersForSecurity(const std::string& securityId, Visitor&& visit) const;
+
+        // Streams the resting orders of one user.
+        template <class Visitor>
+        void visitOrdersForUser(const std::string& user, Visitor&& visit) const;
+
+        // Streams every resting order in ascending order ID.
+        template <class Visitor>
+        void visitOrdersById(Visitor&& visit) const;
+
+        // Maintains the ordered-by-orderId view incrementally, so sorted dumps
+        // (visitOrdersById, getAllOrders) no longer sort the whole book each time.
+        void setOrderedViewEnabled(bool enabled);
+
+        // Adds a batch of orders under a single lock acquisition; later orders in the batch win
+        // over earlier ones with the same ID. Pass the batch with std::move to avoid copying it.
+        void addOrders(std::vector<Order> orders);
+
+        // Cancels a batch of orders under a single lock acquisition.
+        void cancelOrders(const std::vector<std::string>& orderIds);
+
+        // Restores the cache from the snapshot and journal in 'directory' (created if missing),
+        // then journals every later mutation there, before applying it, so a failed journal write
+        // leaves the cache unchanged. Call once, before the cache is shared.
+        RecoveryStats enablePersistence(const std::string& directory, const JournalOptions& options = {});
+
+        // Writes a snapshot and drops the journal segments it covers, so the next restart
+        // replays only what happened afterwards. The image is captured under a shared lock
+        // and written to disk after it is released. Mutations also run one on their own,
+        // after releasing the lock, every JournalOptions::checkpointEveryRecords records.
+        void checkpoint();
+
+        // Makes every mutation journaled so far durable.
+        void syncJournal();
+
+        // Records every mutation and matching query to an event log at 'path', written by a
+        // background thread. Returns false, and logs nothing, if the build leaves the event
+        // log out (ORDERCACHE_EVENT_LOG off).
+        bool enableEventLog(const std::string& path, const EventLogOptions& options = {});
+
+        // Blocks until the events recorded so far are in the log file.
+        void flushEventLog();
+
+        // Starts or stops timing every operation: latency and cacheMutex wait histograms
+        // per operation. While disabled an operation pays one atomic load.
+        // Histograms survive disabling and keep accumulating when enabled again.
+        void setStatsEnabled(bool enabled);
+
+        // Runs getMatchingSizeForAllSecurities and large cancelOrdersForUser calls on 'threads'
+        // threads (the caller included); 1 or 0 makes them serial again. Results are the same
+        // either way. Call before the cache is shared.
+        void setParallelism(std::size_t threads);
+
+        // Operation histograms (if stats were ever enabled), order/user/security counts and
+        // hash table occupancy. Takes the shared lock and walks the indexes; meant for monitoring.
+        CacheStatsSnapshot statsSnapshot() const;
+
     private:
-        // Maps each order's unique ID to its Order object for quick retrieval and management.
-        std::unordered_map<std::string, Order> orders;
+        // Orders and their indexes.
+        OrderBook book;
+
+        // Reader/writer lock protecting the book.
+        // Mutations take it exclusively; getMatchingSizeForSecurity and getAllOrders share it.
+        mutable FairSharedMutex cacheMutex;
+
+        // Journal and snapshots; null unless enablePersistence() was called.
+        std::unique_ptr<OrderPersistence> persistence;
 
-        // Maps each user's name to a list of order IDs they have placed.
-        // This allows for efficient access and management of orders by user.
-        std::unordered_map<std::string, std::vector<std::string>> userOrders;
+        // Serializes checkpoints, which hold the cache lock only while capturing.
+        std::mutex checkpointMutex;
 
-        // Maps each security ID to a list of order IDs associated with that security.
-        // Facilitates fast lookups and operations on orders for a particular security.
-        std::unordered_map<std::string, std::vector<std::string>> securityOrders;
+        // Releases the writer's lock and writes a snapshot if the journal has grown enough.
+        void checkpointIfDue(std::unique_lock<FairSharedMutex>& lock);
 
-        // Updates internal mappings (userOrders and securityOrders) when a new order is added.
-        // Ensures that orders can be efficiently accessed by both user and security ID.
-        void updateMappingsOnAdd(const Order& order);
+        // Captures and writes a snapshot; the caller holds checkpointMutex. With onlyIfDue it
+        // gives up when another checkpoint has reset the journal count meanwhile.
+        void writeCheckpoint(bool onlyIfDue);
 
-        // Updates internal mappings when an order is removed.
-        // Removes the order's associations from userOrders and securityOrders to keep the data consistent.
-        void updateMappingsOnCancel(const Order& order);
+        // Event log; null unless enableEventLog() was called. Shared so flushEventLog() can
+        // keep it alive while waiting without holding the cache lock.
+        std::shared_ptr<EventLog> eventLog;
 
-        // Mutex for protecting access to the above member variables
-        mutable std::mutex cacheMutex;
+        // Threads for the parallel queries and bulk cancels; null while they run serially.
+        std::unique_ptr<WorkStealingPool> pool;
+
+        // Operation histograms, created on first enable and never replaced afterwards,
+        // so operations can use them without the lock once statsEnabled is seen set.
+        std::unique_ptr<CacheStats> stats;
+        std::atomic<bool> statsEnabled{false};
+
+        // Histograms to record into, or null while stats are disabled.
+        CacheStats* activeStats() const {
+            return statsEnabled.load(std::memory_order_acquire) ? stats.get() : nullptr;
+        }
 };
+
+template <class Visitor>
+void OrderCache::visitOrders(Visitor&& visit) const {
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);
+    book.visitOrders(std::forward<Visitor>(visit));
+}
+
+template <class Visitor>
+void OrderCache::visitOrdersForSecurity(const std::string& securityId, Visitor&& visit) const {
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);
+    book.visitOrdersForSecurity(securityId, std::forward<Visitor>(visit));
+}
+
+template <class Visitor>
+void OrderCache::visitOrdersForUser(const std::string& user, Visitor&& visit) const {
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);
+    book.visitOrdersForUser(user, std::forward<Visitor>(visit));
+}
+
+template <class Visitor>
+void OrderCache::visitOrdersById(Visitor&& visit) const {
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);
+    book.visitOrdersById(std::forward<Visitor>(visit));
+}
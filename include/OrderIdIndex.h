@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "BookStats.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ORDERCACHE_SSE2_GROUPS 1
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Open-addressing hash index from order IDs to record handles, laid out like a SwissTable.
+//
+// Slots come in groups of 16, each slot with a control byte that holds 7 bits of its entry's
+// hash (or marks it empty or deleted). A probe compares a whole group of control bytes with
+// one SSE2 instruction and looks at the slots only for the bytes that match. The index does
+// not store keys: callers pass the key's hash plus a predicate that checks a handle's key,
+// and keep the hash next to the key so that neither growth nor erase ever rehashes a string.
+//
+// Growth is incremental. When the table fills up, a new one (usually twice the size) is
+// allocated and every later insert or erase moves a few groups of the old table over, while
+// lookups check both. No single insert pays for moving the whole index.
+//
+// Not thread-safe: the index belongs to one OrderBook and is used under the book's lock.
+class OrderIdIndex {
+
+    public:
+        using Handle = std::uint32_t;
+
+        // Returned by find() when no entry matches.
+        static constexpr Handle npos = static_cast<Handle>(-1);
+
+        // Hash of an order ID as the index expects it. std::hash is not guaranteed to spread
+        // its low bits, so they are mixed before the control bits are taken from them.
+        static std::uint64_t hash(std::string_view orderId) {
+            std::uint64_t h = std::hash<std::string_view>{}(orderId);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        OrderIdIndex() = default;
+        ~OrderIdIndex();
+
+        OrderIdIndex(const OrderIdIndex&) = delete;
+        OrderIdIndex& operator=(const OrderIdIndex&) = delete;
+
+        // Number of entries.
+        std::size_t size() const { return current.size + previous.size; }
+
+        // Slots the index can fill before it has to grow again.
+        std::size_t capacity() const { return maxUsed(current); }
+
+        // Makes room for 'expected' entries. The move to a larger table is incremental like any other growth.
+        void reserve(std::size_t expected);
+
+        // Returns the handle of the entry with this hash for which keyEquals(handle) is true, or npos.
+        template <class KeyEquals>
+        Handle find(std::uint64_t hash, KeyEquals&& keyEquals) const;
+
+        // Adds an entry. The caller makes sure no entry with an equal key is present.
+        void insert(std::uint64_t hash, Handle handle);
+
+        // Removes the entry with this hash and handle. Returns false if there was no such entry.
+        bool erase(std::uint64_t hash, Handle handle);
+
+        // Calls visit(Handle) for every entry, in no particular order.
+        template <class Visitor>
+        void forEach(Visitor&& visit) const;
+
+        // Occupancy of the index. 'buckets' are slots, 'usedBuckets' the slots that hold an entry
+        // or a tombstone, 'collidedEntries' the entries outside their home group and 'longestChain'
+        // the most groups a lookup has to probe. Walks every slot, so it costs O(capacity).
+        HashTableStats stats(std::string name) const;
+
+    private:
+        static constexpr std::size_t groupSize = 16;
+
+        // Groups of the old table moved over per insert or erase. Growth starts when a table is
+        // 7/8 full and the new table is at least as large, so the old one is always drained
+        // long before the new one fills up.
+        static constexpr std::size_t migrateGroupsPerStep = 4;
+
+        // Control bytes: full slots carry the top bit plus 7 hash bits. Empty is zero so that
+        // tables start out as zeroed pages and never need a clearing pass.
+        static constexpr std::uint8_t emptyByte = 0x00;
+        static constexpr std::uint8_t deletedByte = 0x01;
+
+        struct Slot {
+            Handle handle;
+            // Hash bits above the control bits, which pick the entry's home group.
+            std::uint32_t home;
+        };
+
+        struct Table {
+            std::uint8_t* control = nullptr;
+            Slot* slots = nullptr;
+            std::size_t groups = 0;  // a power of two, or 0 before the first insert
+            std::size_t size = 0;    // entries
+            std::size_t used = 0;    // entries and tombstones
+        };
+
+        // Table new entries go to.
+        Table current;
+
+        // Table being drained into 'current' after growth; empty once drained.
+        Table previous;
+
+        // Next group of 'previous' to move.
+        std::size_t migrateCursor = 0;
+
+        static std::uint8_t controlOf(std::uint64_t hash) { return static_cast<std::uint8_t>(0x80 | (hash & 0x7F)); }
+        static std::uint32_t homeOf(std::uint64_t hash) { return static_cast<std::uint32_t>(hash >> 7); }
+
+        static std::size_t maxUsed(const Table& table) {
+            std::size_t slots = table.groups * groupSize;
+            return slots - slots / 8;
+        }
+
+        // Bit i is set when control byte i of the group equals 'value'.
+        static std::uint32_t matchByte(const std::uint8_t* group, std::uint8_t value) {
+#if defined(ORDERCACHE_SSE2_GROUPS)
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(value)))));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < groupSize; ++i) {
+                mask |= std::uint32_t(group[i] == value) << i;
+            }
+            return mask;
+#endif
+        }
+
+        // Bit i is set when slot i of the group is empty or deleted.
+        static std::uint32_t matchFree(const std::uint8_t* group) {
+#if defined(ORDERCACHE_SSE2_GROUPS)
+            // Only full slots have the top bit set
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return ~static_cast<std::uint32_t>(_mm_movemask_epi8(bytes)) & 0xFFFF;
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < groupSize; ++i) {
+                mask |= std::uint32_t(!(group[i] & 0x80)) << i;
+            }
+            return mask;
+#endif
+        }
+
+        static unsigned lowestBit(std::uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+
+        template <class KeyEquals>
+        static Handle findIn(const Table& table, std::uint64_t hash, KeyEquals& keyEquals);
+
+        // Allocates a table of 'groups' empty groups.
+        static Table allocate(std::size_t groups);
+        static void release(Table& table);
+
+        // Puts an entry known to be absent into the table's first free slot on its probe sequence.
+        static void place(Table& table, std::uint32_t home, std::uint8_t control, Handle handle);
+
+        // Erases the entry from one table; returns false if it is not there.
+        static bool eraseFrom(Table& table, std::uint32_t home, std::uint8_t control, Handle handle);
+
+        // Switches to a new table of 'groups' groups and starts draining the current one into it.
+        void grow(std::size_t groups);
+
+        // Moves up to 'groups' groups of 'previous' into 'current', releasing 'previous' once drained.
+        void migrate(std::size_t groups);
+};
+
+template <class KeyEquals>
+OrderIdIndex::Handle OrderIdIndex::find(std::uint64_t hash, KeyEquals&& keyEquals) const {
+    Handle handle = findIn(current, hash, keyEquals);
+    if (handle == npos && previous.size > 0) {
+        handle = findIn(previous, hash, keyEquals);
+    }
+    return handle;
+}
+
+template <class KeyEquals>
+OrderIdIndex::Handle OrderIdIndex::findIn(const Table& table, std::uint64_t hash, KeyEquals& keyEquals) {
+    if (table.groups == 0) {
+        return npos;
+    }
+    std::uint32_t home = homeOf(hash);
+    std::uint8_t control = controlOf(hash);
+    std::size_t groupMask = table.groups - 1;
+    // Triangular probing visits every group once when the group count is a power of two
+    std::size_t group = home & groupMask;
+    for (std::size_t step = 1;; ++step) {
+        const std::uint8_t* bytes = table.control + group * groupSize;
+        for (std::uint32_t candidates = matchByte(bytes, control); candidates; candidates &= candidates - 1) {
+            const Slot& slot = table.slots[group * groupSize + lowestBit(candidates)];
+            if (slot.home == home && keyEquals(slot.handle)) {
+                return slot.handle;
+            }
+        }
+        // An insert would have used the empty slot, so the key cannot sit further along
+        if (matchByte(bytes, emptyByte)) {
+            return npos;
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+template <class Visitor>
+void OrderIdIndex::forEach(Visitor&& visit) const {
+    for (const Table* table : {&current, &previous}) {
+        std::size_t slots = table->groups * groupSize;
+        for (std::size_t slot = 0; slot < slots; ++slot) {
+            if (table->control[slot] & 0x80) {
+                visit(table->slots[slot].handle);
+            }
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "OrderBook.h"
+
+// Tuning of the write-ahead journal.
+struct JournalOptions {
+    // Records between two fsyncs; 1 makes every mutation durable before the call returns.
+    // Every record is written to the file as it is logged, so a crash of the process loses
+    // nothing; a power loss or OS crash can lose up to this many of the latest records.
+    std::size_t syncEveryRecords = 1024;
+
+    // Journal records after which the owning cache writes a snapshot on its own, which bounds
+    // the journal on disk and the replay on restart; 0 leaves snapshots to explicit checkpoints.
+    std::size_t checkpointEveryRecords = 1 << 20;
+};
+
+// What recover() found on disk.
+struct RecoveryStats {
+    std::size_t snapshotOrders = 0;   // orders loaded from the snapshot
+    std::size_t journalRecords = 0;   // journal records replayed after it
+    bool truncatedTail = false;       // a torn or corrupt journal tail was cut off
+};
+
+// Crash-safe persistence for an order book, kept in one local directory:
+//
+//  - journal-<seq>.log  append-only binary journal segments. Each record is framed as
+//                       [u32 body length][u32 CRC-32 of body][body], so a write torn by a crash
+//                       is detected and cut off on recovery.
+//  - snapshot.bin       the book at the start of a journal segment, in a fixed-layout format
+//                       (header, symbol table, 32-byte order entries, string blob) that is
+//                       memory-mapped and walked on load without any parsing.
+//
+// Warm restart loads the snapshot and replays only the journal segments written after it.
+// Writing a snapshot rolls the journal to a new segment and deletes the ones it covers.
+//
+// Not thread-safe: the owning cache calls the log functions under its exclusive lock and
+// captureSnapshot() under a lock that excludes mutations.
+class OrderPersistence {
+
+    public:
+        explicit OrderPersistence(std::string directory, JournalOptions options = {});
+
+        // Writes and fsyncs anything still buffered.
+        ~OrderPersistence();
+
+        OrderPersistence(const OrderPersistence&) = delete;
+        OrderPersistence& operator=(const OrderPersistence&) = delete;
+
+        // Loads the latest snapshot and journal tail into 'book', then opens a fresh journal
+        // segment for appending. Must be called once before any mutation is logged.
+        // Throws std::runtime_error if the directory or the snapshot cannot be read.
+        RecoveryStats recover(OrderBook& book);
+
+        // Journal one mutation. The record is in the file when the call returns, and survives
+        // a power loss once the next fsync (see syncEveryRecords) or sync() has run.
+        void logAdd(const Order& order);
+        void logCancel(const std::string& orderId);
+        void logCancelForUser(const std::string& user);
+        void logCancelForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty);
+
+        // Writes buffered records and fsyncs the journal.
+        void sync();
+
+        // True once checkpointEveryRecords records were journaled (or replayed) since the last snapshot.
+        bool checkpointDue() const {
+            return options.checkpointEveryRecords != 0 && recordsSinceSnapshot >= options.checkpointEveryRecords;
+        }
+
+        // Rolls the journal to a new segment and serializes the book into a snapshot image.
+        // The book must not change while this runs; the image is written by commitSnapshot().
+        std::vector<char> captureSnapshot(const OrderBook& book);
+
+        // Durably replaces snapshot.bin with the image and deletes the journal segments it covers.
+        // Does not touch the book, so it can run without holding the cache lock.
+        void commitSnapshot(const std::vector<char>& image);
+
+    private:
+        std::string directory;
+        JournalOptions options;
+
+        // Journal segment currently appended to.
+        std::FILE* journal = nullptr;
+        std::uint64_t journalSegment = 0;
+
+        // The record being framed, and records written since the last fsync.
+        std::vector<char> buffer;
+        std::size_t unsyncedRecords = 0;
+
+        // Records in the journal segments the next recovery would replay.
+        std::size_t recordsSinceSnapshot = 0;
+
+        // Journal segment the captured snapshot starts at, set by captureSnapshot().
+        std::uint64_t snapshotSegment = 0;
+
+        std::string segmentPath(std::uint64_t segment) const;
+        std::string snapshotPath() const;
+
+        // Journal segment numbers present in the directory, ascending.
+        std::vector<std::uint64_t> listSegments() const;
+
+        // Closes the current segment (if any) after syncing it and starts 'segment'.
+        void openSegment(std::uint64_t segment);
+
+        // Frames the body accumulated in 'buffer' from 'bodyStart', writes the record to the
+        // file and fsyncs every syncEveryRecords records.
+        void finishRecord(std::size_t bodyStart);
+
+        // Writes the buffer to the file, without fsync.
+        void flushBuffer();
+
+        // Loads snapshot.bin into the book; returns the segment the journal replay starts at.
+        std::uint64_t loadSnapshot(OrderBook& book, RecoveryStats& stats) const;
+
+        // Replays one journal segment into the book. A torn tail is truncated away.
+        void replaySegment(std::uint64_t segment, OrderBook& book, RecoveryStats& stats) const;
+};
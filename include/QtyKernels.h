@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Side of a resting order as the book stores it. Only Buy and Sell take part in matching;
+// any other side string is kept for round-tripping but never matches.
+enum class OrderSide : std::uint8_t { Buy, Sell, Other };
+
+// Number and total quantity of a set of resting orders.
+struct QtyTotals {
+    std::size_t orders = 0;
+    std::uint64_t qty = 0;
+};
+
+// Instruction set a kernel table is built for.
+enum class KernelIsa { Scalar, SSE4, AVX2 };
+
+// Reductions over the integer columns the order book keeps per security, in scalar,
+// SSE4.2 and AVX2 flavours. best() picks the widest flavour the CPU supports, once.
+// All flavours return identical results; they differ only in speed.
+struct QtyKernels {
+    KernelIsa isa;
+
+    // Counts and sums the qty[i] >= minQty.
+    QtyTotals (*totalsAtLeast)(const std::uint32_t* qty, std::size_t rows, std::uint32_t minQty);
+
+    // Returns the largest buy[i] + sell[i], or 0 for no rows.
+    std::uint64_t (*maxSum)(const std::uint64_t* buy, const std::uint64_t* sell, std::size_t rows);
+
+    // Kernels for the running CPU.
+    static const QtyKernels& best();
+
+    // Kernels for a specific instruction set, or nullptr if this CPU or build lacks it.
+    static const QtyKernels* forIsa(KernelIsa isa);
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex> // For std::mutex
+#include <shared_mutex> // For std::shared_lock
+
+#include "../OrderCacheInterface.cpp" // Make sure this header includes the OrderCacheInterface definition.
+#include "OrderBook.h"
+#include "FairSharedMutex.h"
+#include "CacheStats.h"
+
+// Order cache partitioned by securityId hash into independently locked shards.
+// Threads working on different securities mostly take different locks, so
+// ingest scales with cores instead of serializing on a single cache mutex.
+class ShardedOrderCache : public OrderCacheInterface {
+
+    public:
+        // Creates the cache with the given number of shards (at least one).
+        explicit ShardedOrderCache(std::size_t shardCount = defaultShardCount());
+        ~ShardedOrderCache() = default;
+
+        // Adds the order to the shard owning its security and records the order ID's route.
+        // An order with the same ID replaces the resting one, even if it lives in another shard.
+        void addOrder(Order order) override;
+
+        // Cancels an order, locating its shard through the order ID route.
+        void cancelOrder(const std::string& orderId) override;
+
+        // Cancels the user's orders in every shard, taking one shard lock at a time.
+        // With setParallelism() the shards are worked on in parallel.
+        void cancelOrdersForUser(const std::string& user) override;
+
+        // Cancels the security's orders with qty >= minQty; only the security's shard is locked.
+        void cancelOrdersForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) override;
+
+        // Returns the matching size of the security; only the security's shard is locked.
+        unsigned int getMatchingSizeForSecurity(const std::string& securityId) override;
+
+        // Returns the matching size of every security with resting orders, sorted by security ID.
+        // Each shard is shared-locked on its own while its securities are computed; with
+        // setParallelism() the shards are computed in parallel.
+        std::vector<SecurityMatch> getMatchingSizeForAllSecurities() const;
+
+        // Returns the number and total qty of the security's orders with qty >= minQty;
+        // only the security's shard is locked.
+        QtyTotals getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) const;
+
+        // Returns a consistent snapshot of all orders, sorted by order ID.
+        // All shard locks are shared together while the orders are copied.
+        std::vector<Order> getAllOrders() const override;
+
+        // Streams every resting order to visit(const OrderView&) without copying.
+        // All shard locks are shared for the duration, so the stream is a consistent snapshot.
+        // The views are valid only during the call, and the visitor must not call back into the cache.
+        template <class Visitor>
+        void visitOrders(Visitor&& visit) const;
+
+        // Streams the resting orders of one security; only the security's shard is locked.
+        template <class Visitor>
+        void visitOrdersForSecurity(const std::string& securityId, Visitor&& visit) const;
+
+        // Streams the resting orders of one user from every shard, as one consistent snapshot.
+        template <class Visitor>
+        void visitOrdersForUser(const std::string& user, Visitor&& visit) const;
+
+        // Streams every resting order in ascending order ID. The shards' views are merged
+        // by sorting lightweight OrderViews, never copies of the orders.
+        template <class Visitor>
+        void visitOrdersById(Visitor&& visit) const;
+
+        // Adds a batch of orders. The route stripes involved are locked together in index
+        // order, then each target shard is locked once for all of its orders.
+        void addOrders(std::vector<Order> orders);
+
+        // Cancels a batch of orders, locking each involved stripe and shard once.
+        void cancelOrders(const std::vector<std::string>& orderIds);
+
+        // Preallocates storage for the expected peak order count, spread evenly over the shards.
+        void reserve(std::size_t expectedOrders);
+
+        // Runs getMatchingSizeForAllSecurities and cancelOrdersForUser on 'threads' threads
+        // (the caller included), one shard per job; 1 or 0 makes them serial again.
+        // Results are the same either way. Call before the cache is shared.
+        void setParallelism(std::size_t threads);
+
+        // Starts or stops timing every operation into latency and lock-wait histograms.
+        // Lock wait is recorded by operations that take their locks up front: the single-order
+        // and single-security ones, the batches (their route stripes) and getAllOrders (all shards).
+        // cancelOrdersForUser and getMatchingSizeForAllSecurities lock shard by shard and record
+        // latency only. While disabled an operation pays one atomic load.
+        void setStatsEnabled(bool enabled);
+
+        // Operation histograms (if stats were ever enabled) and the shards' counts and hash
+        // table occupancy added together; a user or company in several shards counts once per shard.
+        // Shares one shard lock at a time and walks the indexes; meant for monitoring.
+        CacheStatsSnapshot statsSnapshot() const;
+
+        // Number of shards the orders are partitioned over.
+        std::size_t shardCount() const { return shards.size(); }
+
+        // Default shard count: a few shards per hardware thread to keep collisions rare.
+        static std::size_t defaultShardCount();
+
+    private:
+        // One partition of the orders; aligned so neighbouring locks do not share a cache line.
+        // Queries share the shard lock, mutations take it exclusively.
+        struct alignas(64) Shard {
+            mutable FairSharedMutex mutex;
+            OrderBook book;
+        };
+
+        // One stripe of the order ID -> shard routing table.
+        // Lock order is always route stripe before shard, so writers never deadlock.
+        struct alignas(64) RouteStripe {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::uint32_t> shardOf;
+        };
+
+        // Shards owning the orders, selected by securityId hash.
+        std::vector<Shard> shards;
+
+        // Route stripes selected by order ID hash.
+        std::vector<RouteStripe> routes;
+
+        // Threads for the per-shard parallel paths; null while they run serially.
+        std::unique_ptr<WorkStealingPool> pool;
+
+        // Operation histograms, created on first enable and never replaced afterwards,
+        // so operations can use them without a lock once statsEnabled is seen set.
+        std::unique_ptr<CacheStats> stats;
+        std::atomic<bool> statsEnabled{false};
+
+        // Serializes setStatsEnabled against itself and statsSnapshot.
+        mutable std::mutex statsMutex;
+
+        // Histograms to record into, or null while stats are disabled.
+        CacheStats* activeStats() const {
+            return statsEnabled.load(std::memory_order_acquire) ? stats.get() : nullptr;
+        }
+
+        // Calls work(shardIndex) for every shard, on the pool when there is one.
+        void forEachShard(const std::function<void(std::size_t)>& work) const;
+
+        // Shares every shard lock in index order, giving a consistent view of the whole cache.
+        std::vector<std::shared_lock<FairSharedMutex>> lockAllShards() const;
+
+        // Returns the index of the shard owning the security.
+        std::uint32_t shardFor(const std::string& securityId) const;
+
+        // Returns the route stripe for the order ID.
+        RouteStripe& routeFor(const std::string& orderId);
+
+        // Returns the index of the route stripe for the order ID.
+        std::size_t stripeFor(const std::string& orderId) const;
+
+        // Locks the stripes of all the given order IDs, in ascending stripe order.
+        std::vector<std::unique_lock<std::mutex>> lockStripes(const std::vector<std::string>& orderIds);
+
+        // Drops the routes of orders a bulk cancel removed from the shard.
+        // A route is kept if the order was meanwhile re-added, to this or another shard.
+        void dropRoutes(std::uint32_t shardIndex, const std::vector<std::string>& cancelledIds);
+};
+
+template <class Visitor>
+void ShardedOrderCache::visitOrders(Visitor&& visit) const {
+    auto shardLocks = lockAllShards();
+    for (const auto& shard : shards) {
+        shard.book.visitOrders(visit);
+    }
+}
+
+template <class Visitor>
+void ShardedOrderCache::visitOrdersForSecurity(const std::string& securityId, Visitor&& visit) const {
+    const auto& shard = shards[shardFor(securityId)];
+    std::shared_lock<FairSharedMutex> shardLock(shard.mutex);
+    shard.book.visitOrdersForSecurity(securityId, std::forward<Visitor>(visit));
+}
+
+template <class Visitor>
+void ShardedOrderCache::visitOrdersForUser(const std::string& user, Visitor&& visit) const {
+    auto shardLocks = lockAllShards();
+    for (const auto& shard : shards) {
+        shard.book.visitOrdersForUser(user, visit);
+    }
+}
+
+template <class Visitor>
+void ShardedOrderCache::visitOrdersById(Visitor&& visit) const {
+    auto shardLocks = lockAllShards();
+    std::vector<OrderView> views;
+    for (const auto& shard : shards) {
+        views.reserve(views.size() + shard.book.size());
+        shard.book.visitOrders([&views](const OrderView& order) { views.push_back(order); });
+    }
+    std::sort(views.begin(), views.end(), [](const OrderView& a, const OrderView& b) {
+        return a.orderId < b.orderId;
+    });
+    for (const auto& order : views) {
+        visit(order);
+    }
+}
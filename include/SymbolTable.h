@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BookStats.h"
+
+// Dense integer identifier assigned to an interned string.
+using SymbolId = std::uint32_t;
+
+// Interns strings (user names, companies, security IDs) into dense integer IDs.
+// Each distinct string is stored exactly once. IDs are handed out sequentially
+// starting at 0 and are never reused, so they can directly index plain vectors.
+class SymbolTable {
+
+    public:
+        // Returned by find() when the string has never been interned.
+        static constexpr SymbolId npos = static_cast<SymbolId>(-1);
+
+        // Returns the ID for the given string, assigning the next free ID on first sight.
+        // Bursts usually repeat the same symbol, so the last result is checked before hashing.
+        SymbolId intern(const std::string& name) {
+            if (lastId != npos && *names[lastId] == name) {
+                return lastId;
+            }
+            auto [iter, inserted] = ids.try_emplace(name, static_cast<SymbolId>(names.size()));
+            if (inserted) {
+                // unordered_map nodes never move, so the key can be referenced directly.
+                names.push_back(&iter->first);
+            }
+            lastId = iter->second;
+            return lastId;
+        }
+
+        // Returns the ID for the given string without interning it, or npos if unknown.
+        SymbolId find(const std::string& name) const {
+            auto iter = ids.find(name);
+            return iter != ids.end() ? iter->second : npos;
+        }
+
+        // Returns the string behind an ID previously returned by intern().
+        const std::string& name(SymbolId id) const { return *names[id]; }
+
+        // Number of distinct strings interned so far.
+        std::size_t size() const { return names.size(); }
+
+        // Occupancy of the string -> ID hash table.
+        HashTableStats hashStats(std::string tableName) const { return HashTableStats::measure(std::move(tableName), ids); }
+
+    private:
+        // Maps each distinct string to its ID.
+        std::unordered_map<std::string, SymbolId> ids;
+
+        // Reverse mapping from ID to the string stored as key in 'ids'.
+        std::vector<const std::string*> names;
+
+        // ID returned by the previous intern() call.
+        SymbolId lastId = npos;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run index-parallel loops for the caches.
+//
+// run(count, task) spreads task(0) .. task(count - 1) over one job queue per thread in
+// contiguous blocks. Each thread takes jobs from the back of its own queue and, once it is
+// empty, steals from the front of the others', so uneven jobs (a security with many orders
+// next to many small ones) still keep every thread busy. The calling thread works along
+// and run() returns when all of its jobs are done. Several threads may call run() at once.
+class WorkStealingPool {
+
+    public:
+        // Runs loops on 'threads' threads in total: the caller plus threads - 1 workers.
+        explicit WorkStealingPool(std::size_t threads);
+
+        // Stops the workers. No run() may be in progress.
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // Threads a loop runs on, the caller included.
+        std::size_t concurrency() const { return queues.size(); }
+
+        // Calls task(i) for every i in [0, count), in no particular order or thread, and waits
+        // for all of them. If tasks throw, the exception of one of them is rethrown afterwards.
+        // Tasks must not call run() themselves.
+        void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    private:
+        // One run() call.
+        struct Batch {
+            const std::function<void(std::size_t)>* task = nullptr;
+            std::atomic<std::size_t> pending{0};
+            std::mutex errorMutex;
+            std::exception_ptr error;
+        };
+
+        struct Job {
+            Batch* batch;
+            std::size_t index;
+        };
+
+        // Jobs of one thread; queue 0 belongs to the callers of run().
+        struct alignas(64) Queue {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        std::vector<Queue> queues;
+        std::vector<std::thread> workers;
+
+        // Jobs queued and not yet taken, so idle workers know when to sleep.
+        std::atomic<std::size_t> queued{0};
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        // Takes a job from queue 'home', or steals one from another queue, and runs it.
+        // Returns false if every queue was empty.
+        bool runOne(std::size_t home);
+
+        // Worker thread body.
+        void work(std::size_t home);
+};
@@ -0,0 +1,220 @@
+#include "../include/AsyncOrderCache.h"
+#include <algorithm>
+
+namespace {
+    // Gives the core to another thread while this one busy-waits.
+    void relax() {
+        std::this_thread::yield();
+    }
+}
+
+AsyncOrderCache::AsyncOrderCache(AsyncOrderCacheOptions options)
+    : options(options), commands(options.capacity) {
+    applier = std::thread([this] { apply(); });
+}
+
+AsyncOrderCache::~AsyncOrderCache() {
+    stopping.store(true, std::memory_order_release);
+    applier.join();
+}
+
+// Helper function to queue a command, waiting for room when the ring is full
+void AsyncOrderCache::submit(Command&& command) const {
+    // A failed push leaves the command as it was, ready for the next attempt
+    while (!commands.tryPush(std::move(command))) {
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        relax();
+    }
+}
+
+void AsyncOrderCache::addOrder(Order order) {
+    OpTimer timer(activeStats(), CacheOp::AddOrder);
+    Command command;
+    command.type = CommandType::Add;
+    command.order = std::move(order);
+    submit(std::move(command));
+    timer.locked();
+}
+
+void AsyncOrderCache::cancelOrder(const std::string& orderId) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrder);
+    Command command;
+    command.type = CommandType::Cancel;
+    command.key = orderId;
+    submit(std::move(command));
+    timer.locked();
+}
+
+void AsyncOrderCache::addOrders(std::vector<Order> orders) {
+    OpTimer timer(activeStats(), CacheOp::AddOrders);
+    Command command;
+    command.type = CommandType::AddBatch;
+    command.batch = std::move(orders);
+    submit(std::move(command));
+    timer.locked();
+}
+
+void AsyncOrderCache::cancelOrders(const std::vector<std::string>& orderIds) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrders);
+    for (const auto& orderId : orderIds) {
+        Command command;
+        command.type = CommandType::Cancel;
+        command.key = orderId;
+        submit(std::move(command));
+    }
+    timer.locked();
+}
+
+void AsyncOrderCache::cancelOrdersForUser(const std::string& user) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrdersForUser);
+    Command command;
+    command.type = CommandType::CancelForUser;
+    command.key = user;
+    submit(std::move(command));
+    timer.locked();
+}
+
+void AsyncOrderCache::cancelOrdersForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrdersForSecIdWithMinimumQty);
+    Command command;
+    command.type = CommandType::CancelForSecIdWithMinimumQty;
+    command.key = securityId;
+    command.minQty = minQty;
+    submit(std::move(command));
+    timer.locked();
+}
+
+unsigned int AsyncOrderCache::getMatchingSizeForSecurity(const std::string& securityId) {
+    OpTimer timer(activeStats(), CacheOp::GetMatchingSizeForSecurity);
+    return timedQuery(&timer, [&securityId](const OrderBook& book) {
+        return book.getMatchingSizeForSecurity(securityId);
+    });
+}
+
+QtyTotals AsyncOrderCache::getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) const {
+    return query([&](const OrderBook& book) { return book.getQtyTotalsForSecIdWithMinimumQty(securityId, minQty); });
+}
+
+std::vector<Order> AsyncOrderCache::getAllOrders() const {
+    OpTimer timer(activeStats(), CacheOp::GetAllOrders);
+    // Hold the applier only for the copy
+    std::vector<Order> allOrders = timedQuery(&timer, [](const OrderBook& book) {
+        std::vector<Order> copy;
+        book.appendOrders(copy);
+        return copy;
+    });
+    std::sort(allOrders.begin(), allOrders.end(), [](const Order& a, const Order& b) {
+        return a.orderId() < b.orderId();
+    });
+    return allOrders;
+}
+
+void AsyncOrderCache::reserve(std::size_t expectedOrders) {
+    struct ReserveTask : Task {
+        explicit ReserveTask(std::size_t expectedOrders) : expectedOrders(expectedOrders) {}
+        void run(OrderBook& book) override { book.reserve(expectedOrders); }
+        std::size_t expectedOrders;
+    };
+    ReserveTask task(expectedOrders);
+    execute(task);
+}
+
+void AsyncOrderCache::setStatsEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    if (enabled && !stats) {
+        stats = std::make_unique<CacheStats>();
+    }
+    statsEnabled.store(enabled, std::memory_order_release);
+}
+
+CacheStatsSnapshot AsyncOrderCache::statsSnapshot() const {
+    CacheStatsSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        if (stats) {
+            snapshot.operations = stats->operations();
+        }
+    }
+    snapshot.book = query([](const OrderBook& book) { return book.stats(); });
+    return snapshot;
+}
+
+void AsyncOrderCache::flush() const {
+    struct BarrierTask : Task {
+        void run(OrderBook&) override {}
+    };
+    BarrierTask task;
+    execute(task);
+}
+
+// Helper function to run a task on the applier and wait for it
+void AsyncOrderCache::execute(Task& task, OpTimer* timer) const {
+    Command command;
+    command.type = CommandType::Run;
+    command.task = &task;
+    submit(std::move(command));
+    if (timer) {
+        timer->locked();
+    }
+    while (!task.done.load(std::memory_order_acquire)) {
+        relax();
+    }
+    if (task.error) {
+        std::rethrow_exception(task.error);
+    }
+}
+
+// Helper function run by the applier thread
+void AsyncOrderCache::apply() {
+    Command command;
+    unsigned idle = 0;
+    for (;;) {
+        // Read the flag first, so a stop request cannot overtake the last commands
+        bool stop = stopping.load(std::memory_order_acquire);
+        if (!commands.tryPop(command)) {
+            if (stop) {
+                return;
+            }
+            if (++idle < options.idleSpins) {
+                relax();
+            } else {
+                std::this_thread::sleep_for(options.idleSleep);
+            }
+            continue;
+        }
+        idle = 0;
+
+        try {
+            switch (command.type) {
+                case CommandType::Add:
+                    book.addOrder(command.order);
+                    break;
+                case CommandType::AddBatch:
+                    book.addOrders(command.batch);
+                    break;
+                case CommandType::Cancel:
+                    book.cancelOrder(command.key);
+                    break;
+                case CommandType::CancelForUser:
+                    book.cancelOrdersForUser(command.key);
+                    break;
+                case CommandType::CancelForSecIdWithMinimumQty:
+                    book.cancelOrdersForSecIdWithMinimumQty(command.key, command.minQty);
+                    break;
+                case CommandType::Run:
+                    try {
+                        command.task->run(book);
+                    } catch (...) {
+                        command.task->error = std::current_exception();
+                    }
+                    // The caller owns the task and may destroy it as soon as it sees the flag
+                    command.task->done.store(true, std::memory_order_release);
+                    break;
+            }
+        } catch (...) {
+            // The producer has long returned, so there is no one to rethrow to; an exception
+            // escaping the thread would terminate the process. Count it and keep applying.
+            failures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include "../include/CacheStats.h"
+#include <iomanip>
+#include <sstream>
+
+const char* cacheOpName(CacheOp op) {
+    switch (op) {
+        case CacheOp::AddOrder: return "addOrder";
+        case CacheOp::AddOrders: return "addOrders";
+        case CacheOp::CancelOrder: return "cancelOrder";
+        case CacheOp::CancelOrders: return "cancelOrders";
+        case CacheOp::CancelOrdersForUser: return "cancelOrdersForUser";
+        case CacheOp::CancelOrdersForSecIdWithMinimumQty: return "cancelOrdersForSecIdWithMinimumQty";
+        case CacheOp::GetMatchingSizeForSecurity: return "getMatchingSizeForSecurity";
+        case CacheOp::GetMatchingSizeForAllSecurities: return "getMatchingSizeForAllSecurities";
+        case CacheOp::GetAllOrders: return "getAllOrders";
+        case CacheOp::Count: break;
+    }
+    return "unknown";
+}
+
+void LatencyHistogram::record(std::uint64_t ns) {
+    counts[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(ns, std::memory_order_relaxed);
+    std::uint64_t seen = minimum.load(std::memory_order_relaxed);
+    while (ns < seen && !minimum.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+    }
+    seen = maximum.load(std::memory_order_relaxed);
+    while (ns > seen && !maximum.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+    }
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary summary;
+    std::array<std::uint64_t, bucketCount> snapshot;
+    for (std::size_t bucket = 0; bucket < bucketCount; ++bucket) {
+        snapshot[bucket] = counts[bucket].load(std::memory_order_relaxed);
+        summary.count += snapshot[bucket];
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.totalNs = total.load(std::memory_order_relaxed);
+    summary.minNs = minimum.load(std::memory_order_relaxed);
+    summary.maxNs = maximum.load(std::memory_order_relaxed);
+
+    // Walk the buckets once, filling the percentiles in ascending order
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    std::uint64_t* targets[] = {&summary.p50Ns, &summary.p90Ns, &summary.p99Ns, &summary.p999Ns};
+    std::size_t next = 0;
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < bucketCount && next < 4; ++bucket) {
+        seen += snapshot[bucket];
+        while (next < 4 && seen >= static_cast<std::uint64_t>(quantiles[next] * summary.count + 0.5) && seen > 0) {
+            // Never report more than the largest value actually recorded
+            *targets[next++] = std::min(bucketUpperBound(bucket), summary.maxNs);
+        }
+    }
+    return summary;
+}
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t ns) {
+    constexpr std::uint64_t subBuckets = 1ULL << subBucketBits;
+    ns = std::min<std::uint64_t>(ns, (1ULL << maxValueBits) - 1);
+    if (ns < subBuckets) {
+        return static_cast<std::size_t>(ns);
+    }
+    unsigned magnitude = 63;
+    while (!(ns >> magnitude)) {
+        --magnitude;
+    }
+    // The top subBucketBits + 1 bits, leading one included, select the bucket within the power of two
+    unsigned shift = magnitude - subBucketBits;
+    return static_cast<std::size_t>(shift) * subBuckets + static_cast<std::size_t>(ns >> shift);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t bucket) {
+    constexpr std::size_t subBuckets = std::size_t(1) << subBucketBits;
+    if (bucket < subBuckets) {
+        return bucket;
+    }
+    std::size_t shift = bucket / subBuckets - 1;
+    std::uint64_t leading = bucket % subBuckets + subBuckets;
+    return ((leading + 1) << shift) - 1;
+}
+
+std::vector<OperationStats> CacheStats::operations() const {
+    std::vector<OperationStats> operations;
+    for (std::size_t op = 0; op < opCount; ++op) {
+        LatencySummary summary = latency[op].summary();
+        if (summary.count > 0) {
+            operations.push_back({cacheOpName(static_cast<CacheOp>(op)), summary, lockWait[op].summary()});
+        }
+    }
+    return operations;
+}
+
+std::string CacheStatsSnapshot::toText() const {
+    std::ostringstream out;
+    out << std::left << std::setw(36) << "operation" << std::right
+        << std::setw(10) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max"
+        << std::setw(12) << "wait mean" << std::setw(12) << "wait p99" << "   (ns)\n";
+    for (const auto& op : operations) {
+        out << std::left << std::setw(36) << op.name << std::right
+            << std::setw(10) << op.latency.count
+            << std::setw(10) << static_cast<std::uint64_t>(op.latency.meanNs())
+            << std::setw(10) << op.latency.p50Ns << std::setw(10) << op.latency.p99Ns
+            << std::setw(10) << op.latency.p999Ns << std::setw(12) << op.latency.maxNs
+            << std::setw(12) << static_cast<std::uint64_t>(op.lockWait.meanNs())
+            << std::setw(12) << op.lockWait.p99Ns << "\n";
+    }
+    out << "\norders " << book.orders << ", users " << book.users << ", securities " << book.securities
+        << ", companies " << book.companies << ", record slots " << book.recordSlots << "\n";
+    for (const auto& table : book.tables) {
+        out << "table " << table.name << ": " << table.entries << " entries in " << table.buckets
+            << " buckets, load " << std::fixed << std::setprecision(2) << table.loadFactor << "/" << table.maxLoadFactor
+            << ", " << table.usedBuckets << " used, " << table.collidedEntries << " collided, longest chain "
+            << table.longestChain << "\n";
+    }
+    return out.str();
+}
+
+namespace {
+    void appendSummary(std::ostringstream& out, const LatencySummary& summary) {
+        out << "{\"count\":" << summary.count << ",\"meanNs\":" << summary.meanNs() << ",\"minNs\":" << summary.minNs
+            << ",\"p50Ns\":" << summary.p50Ns << ",\"p90Ns\":" << summary.p90Ns << ",\"p99Ns\":" << summary.p99Ns
+            << ",\"p999Ns\":" << summary.p999Ns << ",\"maxNs\":" << summary.maxNs << "}";
+    }
+}
+
+std::string CacheStatsSnapshot::toJson() const {
+    // Names are fixed identifiers, so nothing needs escaping
+    std::ostringstream out;
+    out << "{\"operations\":{";
+    for (std::size_t i = 0; i < operations.size(); ++i) {
+        out << (i ? "," : "") << "\"" << operations[i].name << "\":{\"latency\":";
+        appendSummary(out, operations[i].latency);
+        out << ",\"lockWait\":";
+        appendSummary(out, operations[i].lockWait);
+        out << "}";
+    }
+    out << "},\"book\":{\"orders\":" << book.orders << ",\"users\":" << book.users
+        << ",\"securities\":" << book.securities << ",\"companies\":" << book.companies
+        << ",\"recordSlots\":" << book.recordSlots << ",\"tables\":{";
+    for (std::size_t i = 0; i < book.tables.size(); ++i) {
+        const auto& table = book.tables[i];
+        out << (i ? "," : "") << "\"" << table.name << "\":{\"entries\":" << table.entries
+            << ",\"buckets\":" << table.buckets << ",\"loadFactor\":" << table.loadFactor
+            << ",\"maxLoadFactor\":" << table.maxLoadFactor << ",\"usedBuckets\":" << table.usedBuckets
+            << ",\"collidedEntries\":" << table.collidedEntries << ",\"longestChain\":" << table.longestChain << "}";
+    }
+    out << "}}}";
+    return out.str();
+}
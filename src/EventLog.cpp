@@ -0,0 +1,104 @@
+#include "../include/EventLog.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // Copies as much of 'value' as fits, always leaving a terminating zero.
+    template <std::size_t N>
+    void copyField(char (&field)[N], const std::string& value) {
+        std::size_t length = std::min(value.size(), N - 1);
+        std::memcpy(field, value.data(), length);
+        field[length] = '\0';
+    }
+
+    const char* typeName(EventType type) {
+        switch (type) {
+            case EventType::Add: return "add";
+            case EventType::Cancel: return "cancel";
+            case EventType::CancelForUser: return "cancelForUser";
+            case EventType::CancelForSecIdWithMinimumQty: return "cancelForSecIdWithMinimumQty";
+            case EventType::Match: return "match";
+        }
+        return "unknown";
+    }
+
+    constexpr char binaryMagic[8] = {'O', 'C', 'E', 'V', 'L', 'O', 'G', '1'};
+}
+
+EventLog::EventLog(const std::string& path, EventLogOptions options)
+    : options(options), ring(options.capacity) {
+    file = std::fopen(path.c_str(), options.format == EventLogFormat::Binary ? "wb" : "w");
+    if (!file) {
+        throw std::runtime_error("cannot open event log " + path);
+    }
+    if (options.format == EventLogFormat::Binary) {
+        std::fwrite(binaryMagic, 1, sizeof(binaryMagic), file);
+    }
+    drainThread = std::thread([this] { drain(); });
+}
+
+EventLog::~EventLog() {
+    stopping.store(true, std::memory_order_release);
+    drainThread.join();
+    std::fclose(file);
+}
+
+void EventLog::record(EventType type, const std::string& key, const std::string& securityId,
+                      const std::string& side, std::uint32_t qty, std::uint32_t result) {
+    Event event;
+    event.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    event.type = type;
+    copyField(event.side, side);
+    event.qty = qty;
+    event.result = result;
+    copyField(event.key, key);
+    copyField(event.securityId, securityId);
+
+    if (!ring.tryPush(event)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void EventLog::flush() {
+    // Wait on ring positions rather than a count of pushes: a producer that claimed an earlier
+    // position may still be writing its event after a later one has already been pushed
+    std::uint64_t target = ring.claimed();
+    while (written.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(options.drainInterval);
+    }
+}
+
+// Helper function run by the drain thread
+void EventLog::drain() {
+    Event event;
+    for (;;) {
+        // Read the flag first, so a stop request cannot overtake the last events
+        bool stop = stopping.load(std::memory_order_acquire);
+        std::uint64_t batch = 0;
+        while (ring.tryPop(event)) {
+            write(event);
+            ++batch;
+        }
+        if (batch > 0) {
+            std::fflush(file);
+            written.fetch_add(batch, std::memory_order_release);
+        } else if (stop) {
+            return;
+        } else {
+            std::this_thread::sleep_for(options.drainInterval);
+        }
+    }
+}
+
+// Helper function to write one event in the configured format
+void EventLog::write(const Event& event) {
+    if (options.format == EventLogFormat::Binary) {
+        std::fwrite(&event, sizeof(event), 1, file);
+        return;
+    }
+    std::fprintf(file, "%" PRId64 ",%s,%s,%s,%s,%" PRIu32 ",%" PRIu32 "\n", event.timestampNs, typeName(event.type),
+                 event.key, event.securityId, event.side, event.qty, event.result);
+}
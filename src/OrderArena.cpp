@@ -0,0 +1,76 @@
+#include "../include/OrderArena.h"
+#include <algorithm>
+
+namespace {
+    // Index of the size class serving 'bytes' bytes.
+    constexpr std::size_t sizeClass(std::size_t bytes) {
+        return (std::max<std::size_t>(bytes, 1) + OrderArena::granularity - 1) / OrderArena::granularity - 1;
+    }
+}
+
+OrderArena::OrderArena(std::pmr::memory_resource* upstream)
+    : upstream(upstream) {}
+
+OrderArena::~OrderArena() {
+    for (const auto& [chunk, bytes] : chunks) {
+        upstream->deallocate(chunk, bytes, alignof(std::max_align_t));
+    }
+}
+
+void OrderArena::reserve(std::size_t bytes) {
+    if (static_cast<std::size_t>(chunkEnd - cursor) < bytes) {
+        addChunk(bytes);
+    }
+}
+
+void OrderArena::addChunk(std::size_t bytes) {
+    // Round up so the chunk can be carved into whole blocks of any size class
+    bytes = (bytes + granularity - 1) / granularity * granularity;
+    void* chunk = upstream->allocate(bytes, alignof(std::max_align_t));
+    chunks.emplace_back(chunk, bytes);
+    reservedBytes += bytes;
+    cursor = static_cast<std::byte*>(chunk);
+    chunkEnd = cursor + bytes;
+}
+
+void* OrderArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (shared) {
+        lock.lock();
+    }
+    if (bytes > maxBlockSize || alignment > granularity) {
+        return upstream->allocate(bytes, alignment);
+    }
+
+    std::size_t index = sizeClass(bytes);
+    if (FreeBlock* block = freeLists[index]) {
+        freeLists[index] = block->next;
+        return block;
+    }
+
+    std::size_t blockSize = (index + 1) * granularity;
+    if (static_cast<std::size_t>(chunkEnd - cursor) < blockSize) {
+        // Chunks grow geometrically so the number of upstream calls stays logarithmic
+        addChunk(nextChunkSize);
+        nextChunkSize = std::min(nextChunkSize * 2, maxChunkSize);
+    }
+    void* block = cursor;
+    cursor += blockSize;
+    return block;
+}
+
+void OrderArena::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (shared) {
+        lock.lock();
+    }
+    if (bytes > maxBlockSize || alignment > granularity) {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    std::size_t index = sizeClass(bytes);
+    auto* block = static_cast<FreeBlock*>(p);
+    block->next = freeLists[index];
+    freeLists[index] = block;
+}
@@ -0,0 +1,572 @@
+#include "../include/OrderBook.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // Arena bytes reserved per expected order: room for a long order ID and the tree nodes of the views.
+    constexpr std::size_t reservedBytesPerOrder = 64;
+
+    // Qty column rows a vectorized scan covers in the time of one qty-level tree hop.
+    constexpr std::size_t scanRowsPerLevel = 16;
+
+    // Orders a user needs before a pool cancels them in parallel; below that the jobs cost more than they save.
+    constexpr std::size_t parallelCancelMinOrders = 4096;
+
+    // Jobs per pool thread for the all-securities matching report, so stealing can even out skew.
+    constexpr std::size_t matchJobsPerThread = 8;
+}
+
+OrderBook::OrderBook(std::pmr::memory_resource* upstream)
+    : arena(upstream), records(&arena), ordersById(&arena),
+      buySide(sides.intern("Buy")), sellSide(sides.intern("Sell")), kernels(QtyKernels::best()) {}
+
+void OrderBook::reserve(std::size_t expectedOrders) {
+    orders.reserve(expectedOrders);
+    arena.reserve((expectedOrders > orders.size() ? expectedOrders - orders.size() : 0) * reservedBytesPerOrder);
+
+    // Create the missing record slots up front and hand them out lowest handle first
+    std::size_t slots = records.size();
+    if (expectedOrders > slots) {
+        freeHandles.reserve(freeHandles.size() + expectedOrders - slots);
+        for (std::size_t i = slots; i < expectedOrders; ++i) {
+            records.emplace_back(&arena);
+        }
+        for (std::size_t i = expectedOrders; i > slots; --i) {
+            freeHandles.push_back(static_cast<OrderHandle>(i - 1));
+        }
+    }
+}
+
+void OrderBook::addOrder(const Order& order) {
+    // An order with the same ID replaces the resting one
+    OrderHandle existing = findOrder(order.orderId());
+    if (existing != invalidHandle) {
+        updateMappingsOnCancel(existing);
+        releaseRecord(existing);
+    }
+
+    OrderHandle handle = allocateRecord(order);
+    orders.insert(records[handle].idHash, handle);
+    if (orderedView) {
+        ordersById.emplace(records[handle].orderId, handle);
+    }
+    updateMappingsOnAdd(handle);
+}
+
+void OrderBook::addOrders(const std::vector<Order>& batch) {
+    // Size the index for the whole batch up front instead of growing it step by step during the burst
+    orders.reserve(orders.size() + batch.size());
+
+    // Store and index the records in batch order, so repeated IDs resolve exactly as in addOrder.
+    // Until the batch is linked, a record's securityRow holds its position in 'added'.
+    std::vector<OrderHandle> added;
+    added.reserve(batch.size());
+    SymbolId lastUser = 0;
+    SymbolId lastSecurity = 0;
+    for (const auto& order : batch) {
+        OrderHandle existing = findOrder(order.orderId());
+        if (existing != invalidHandle) {
+            if (isLinked(existing)) {
+                updateMappingsOnCancel(existing);
+            } else {
+                added[records[existing].securityRow] = invalidHandle;
+            }
+            releaseRecord(existing);
+        }
+
+        OrderHandle handle = allocateRecord(order);
+        auto& record = records[handle];
+        orders.insert(record.idHash, handle);
+        if (orderedView) {
+            ordersById.emplace(record.orderId, handle);
+        }
+        record.securityRow = static_cast<std::uint32_t>(added.size());
+        added.push_back(handle);
+        lastUser = std::max(lastUser, record.user);
+        lastSecurity = std::max(lastSecurity, record.securityId);
+    }
+    added.erase(std::remove(added.begin(), added.end(), invalidHandle), added.end());
+    if (added.empty()) {
+        return;
+    }
+    growSymbolIndexes(lastUser, lastSecurity);
+
+    // Link security by security, then user by user, each group in batch order: one security's columns,
+    // qty levels and totals stay hot while its orders go in. Per-user and per-qty lists come out
+    // exactly as with addOrder, since each symbol's orders are pushed in batch order.
+    // Sorting symbol and batch position packed into one integer keeps the grouping stable and cheap.
+    std::vector<std::uint64_t> keys(added.size());
+    auto linkGrouped = [&](auto symbolOf, auto link) {
+        for (std::size_t i = 0; i < added.size(); ++i) {
+            keys[i] = static_cast<std::uint64_t>(symbolOf(records[added[i]])) << 32 | i;
+        }
+        std::sort(keys.begin(), keys.end());
+        for (std::uint64_t key : keys) {
+            link(added[static_cast<std::uint32_t>(key)]);
+        }
+    };
+    linkGrouped([](const OrderRecord& record) { return record.securityId; },
+                [this](OrderHandle handle) { linkToSecurity(handle); });
+    linkGrouped([](const OrderRecord& record) { return record.user; },
+                [this](OrderHandle handle) { linkToUser(handle); });
+}
+
+bool OrderBook::cancelOrder(const std::string& orderId) {
+    OrderHandle handle = findOrder(orderId);
+    if (handle == invalidHandle) {
+        return false;
+    }
+    updateMappingsOnCancel(handle);
+    releaseRecord(handle);
+    return true;
+}
+
+std::size_t OrderBook::cancelOrdersForUser(const std::string& user, std::vector<std::string>* cancelledIds,
+                                           WorkStealingPool* pool) {
+    // Users that never placed an order have no symbol and nothing to cancel
+    SymbolId userId = users.find(user);
+    if (userId == SymbolTable::npos) {
+        return 0;
+    }
+
+    auto& list = userOrders[userId];
+    std::size_t cancelled = list.size;
+    if (pool && pool->concurrency() > 1 && list.size >= parallelCancelMinOrders) {
+        std::vector<OrderHandle> handles;
+        handles.reserve(list.size);
+        for (OrderHandle handle = list.head; handle != invalidHandle; handle = records[handle].userNext) {
+            handles.push_back(handle);
+        }
+        // Each security sees its orders removed in list order, exactly as in the serial walk below
+        unlinkFromSecuritiesInParallel(handles, *pool);
+
+        // The ID index and the free list are shared by all securities; release in list order
+        for (OrderHandle handle : handles) {
+            if (cancelledIds) {
+                cancelledIds->emplace_back(records[handle].orderId);
+            }
+            releaseRecord(handle);
+        }
+    } else {
+        // Walk the user's list; only the orders being removed are touched
+        OrderHandle handle = list.head;
+        while (handle != invalidHandle) {
+            OrderHandle next = records[handle].userNext;
+            if (cancelledIds) {
+                cancelledIds->emplace_back(records[handle].orderId);
+            }
+            unlinkFromSecurity(handle);
+            releaseRecord(handle);
+            handle = next;
+        }
+    }
+
+    // Finally, reset the user's now empty list
+    list = OrderList();
+    return cancelled;
+}
+
+
+std::size_t OrderBook::cancelOrdersForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty,
+                                                           std::vector<std::string>* cancelledIds) {
+    SymbolId secId = securities.find(securityId);
+    if (secId == SymbolTable::npos) {
+        return 0;
+    }
+
+    // Only the qty levels at or above minQty are visited; smaller orders are never touched
+    std::size_t cancelled = 0;
+    auto& levels = securityQtyLevels[secId];
+    auto level = levels.lower_bound(minQty);
+    while (level != levels.end()) {
+        // Removing a level's last order erases the level, so step past it first
+        auto nextLevel = std::next(level);
+        OrderHandle handle = level->second.head;
+        while (handle != invalidHandle) {
+            // Read the link before the record is released
+            OrderHandle next = records[handle].qtyNext;
+            if (cancelledIds) {
+                cancelledIds->emplace_back(records[handle].orderId);
+            }
+            updateMappingsOnCancel(handle);
+            releaseRecord(handle);
+            ++cancelled;
+            handle = next;
+        }
+        level = nextLevel;
+    }
+    return cancelled;
+}
+
+// Helper function to count and sum a security's orders with qty >= minQty
+QtyTotals OrderBook::qtyTotalsAtLeast(SymbolId secId, unsigned int minQty) const {
+    // Every order of a level has the level's qty, so each level counts in O(1). A level costs
+    // a tree hop though, so when the qualifying levels are many compared with the security's
+    // orders, a vectorized pass over the qty column is cheaper and the walk gives up.
+    const auto& levels = securityQtyLevels[secId];
+    const auto& columns = securityColumns[secId];
+    std::size_t levelBudget = columns.size() / scanRowsPerLevel;
+    QtyTotals totals;
+    for (auto level = levels.lower_bound(minQty); level != levels.end(); ++level) {
+        if (levelBudget-- == 0) {
+            return kernels.totalsAtLeast(columns.qty.data(), columns.size(), minQty);
+        }
+        totals.orders += level->second.size;
+        totals.qty += static_cast<std::uint64_t>(level->first) * level->second.size;
+    }
+    return totals;
+}
+
+QtyTotals OrderBook::getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) const {
+    QtyTotals totals;
+    SymbolId secId = securities.find(securityId);
+    if (secId == SymbolTable::npos) {
+        return totals;
+    }
+    return qtyTotalsAtLeast(secId, minQty);
+}
+
+unsigned int OrderBook::getMatchingSizeForSecurity(const std::string& securityId) const {
+    SymbolId secId = securities.find(securityId);
+    if (secId == SymbolTable::npos) {
+        return 0;
+    }
+    return matchingSizeOf(secId);
+}
+
+std::vector<SecurityMatch> OrderBook::getMatchingSizeForAllSecurities(WorkStealingPool* pool) const {
+    std::vector<SymbolId> active;
+    for (SymbolId secId = 0; secId < securityColumns.size(); ++secId) {
+        if (securityColumns[secId].size() > 0) {
+            active.push_back(secId);
+        }
+    }
+    std::sort(active.begin(), active.end(), [this](SymbolId a, SymbolId b) {
+        return securities.name(a) < securities.name(b);
+    });
+
+    // Every security fills its own slot, so the result does not depend on the thread that computed it
+    std::vector<SecurityMatch> matches(active.size());
+    auto computeRange = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            matches[i].securityId = securities.name(active[i]);
+            matches[i].matchingSize = matchingSizeOf(active[i]);
+        }
+    };
+    if (!pool || pool->concurrency() == 1) {
+        computeRange(0, active.size());
+        return matches;
+    }
+    std::size_t jobs = std::min(active.size(), pool->concurrency() * matchJobsPerThread);
+    pool->run(jobs, [&](std::size_t job) {
+        computeRange(active.size() * job / jobs, active.size() * (job + 1) / jobs);
+    });
+    return matches;
+}
+
+// Helper function to compute the matching size of an interned security
+unsigned int OrderBook::matchingSizeOf(SymbolId secId) const {
+    const auto& aggregate = securityAggregates[secId];
+
+    // Any buy can match any sell of another company, so the matched size is a maximum flow
+    // between the companies' buy and sell totals. Its only bottlenecks are the total buy
+    // quantity, the total sell quantity, and for each company c the quantity that does not
+    // belong to c (c's buys can only be filled by the other companies' sells and vice versa).
+    std::uint64_t largestCompany = kernels.maxSum(aggregate.buy.data(), aggregate.sell.data(), aggregate.buy.size());
+    std::uint64_t totalMatchedQty = std::min({aggregate.totalBuy, aggregate.totalSell,
+                                              aggregate.totalBuy + aggregate.totalSell - largestCompany});
+
+    return static_cast<unsigned int>(std::min<std::uint64_t>(totalMatchedQty, std::numeric_limits<unsigned int>::max()));
+}
+
+void OrderBook::appendOrders(std::vector<Order>& out) const {
+    out.reserve(out.size() + orders.size());
+    orders.forEach([&](OrderHandle handle) { out.push_back(toOrder(records[handle])); });
+}
+
+void OrderBook::setOrderedViewEnabled(bool enabled) {
+    if (enabled == orderedView) {
+        return;
+    }
+    orderedView = enabled;
+    ordersById.clear();
+    if (enabled) {
+        orders.forEach([&](OrderHandle handle) { ordersById.emplace(records[handle].orderId, handle); });
+    }
+}
+
+BookStats OrderBook::stats() const {
+    BookStats stats;
+    stats.orders = orders.size();
+    stats.users = static_cast<std::size_t>(std::count_if(userOrders.begin(), userOrders.end(),
+                                                         [](const OrderList& list) { return list.size > 0; }));
+    stats.securities = static_cast<std::size_t>(std::count_if(securityColumns.begin(), securityColumns.end(),
+                                                              [](const SecurityColumns& columns) { return columns.size() > 0; }));
+    stats.companies = companies.size();
+    stats.recordSlots = records.size();
+    // Per-user and per-security indexes are dense vectors keyed by SymbolId; their hashing happens in the symbol tables
+    stats.tables.push_back(orders.stats("orders"));
+    stats.tables.push_back(users.hashStats("users"));
+    stats.tables.push_back(securities.hashStats("securities"));
+    stats.tables.push_back(companies.hashStats("companies"));
+    return stats;
+}
+
+bool OrderBook::contains(const std::string& orderId) const {
+    return findOrder(orderId) != invalidHandle;
+}
+
+// Helper function to look an order up by ID
+OrderHandle OrderBook::findOrder(const std::string& orderId) const {
+    OrderHandle handle = orders.find(OrderIdIndex::hash(orderId),
+                                     [&](OrderHandle candidate) { return std::string_view(records[candidate].orderId) == orderId; });
+    return handle == OrderIdIndex::npos ? invalidHandle : handle;
+}
+
+// Helper function to store an order in a free record slot
+OrderHandle OrderBook::allocateRecord(const Order& order) {
+    OrderHandle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        handle = static_cast<OrderHandle>(records.size());
+        records.emplace_back(&arena);
+    }
+
+    auto& record = records[handle];
+    record.orderId = order.orderId();
+    record.idHash = OrderIdIndex::hash(record.orderId);
+    record.securityId = securities.intern(order.securityId());
+    record.side = sides.intern(order.side());
+    record.user = users.intern(order.user());
+    record.company = companies.intern(order.company());
+    record.qty = order.qty();
+    return handle;
+}
+
+// Helper function to drop an order's record and free its slot for reuse
+void OrderBook::releaseRecord(OrderHandle handle) {
+    auto& record = records[handle];
+    orders.erase(record.idHash, handle);
+    if (orderedView) {
+        ordersById.erase(record.orderId);
+    }
+    record.orderId.clear();
+    freeHandles.push_back(handle);
+}
+
+// Helper function to rebuild the public Order object from its record
+Order OrderBook::toOrder(const OrderRecord& record) const {
+    return Order(std::string(record.orderId), securities.name(record.securityId), sides.name(record.side),
+                 record.qty, users.name(record.user), companies.name(record.company));
+}
+
+// Helper function to update mappings when an order is added
+void OrderBook::updateMappingsOnAdd(OrderHandle handle) {
+    growSymbolIndexes(records[handle].user, records[handle].securityId);
+    linkToUser(handle);
+    linkToSecurity(handle);
+}
+
+// Helper function to make room in the per-symbol indexes
+void OrderBook::growSymbolIndexes(SymbolId user, SymbolId secId) {
+    // Symbol IDs are dense, so the per-symbol lists only ever grow by a few slots at a time
+    if (user >= userOrders.size()) {
+        userOrders.resize(user + 1);
+    }
+    if (secId >= securityColumns.size()) {
+        securityColumns.resize(secId + 1);
+        while (securityAggregates.size() <= secId) {
+            securityAggregates.emplace_back(&arena);
+            securityQtyLevels.emplace_back(&arena);
+        }
+    }
+}
+
+// Helper function to push an order at the front of its user's list
+void OrderBook::linkToUser(OrderHandle handle) {
+    auto& record = records[handle];
+    auto& userList = userOrders[record.user];
+    record.userPrev = invalidHandle;
+    record.userNext = userList.head;
+    if (userList.head != invalidHandle) {
+        records[userList.head].userPrev = handle;
+    }
+    userList.head = handle;
+    ++userList.size;
+}
+
+// Helper function to add an order to its security's columns, qty index and matching totals
+void OrderBook::linkToSecurity(OrderHandle handle) {
+    auto& record = records[handle];
+
+    // Append a row to the security's columns
+    auto& columns = securityColumns[record.securityId];
+    OrderSide side = sideOf(record.side);
+    record.securityRow = static_cast<std::uint32_t>(columns.size());
+    columns.qty.push_back(record.qty);
+    columns.side.push_back(side);
+    columns.handle.push_back(handle);
+
+    auto& qtyList = securityQtyLevels[record.securityId][record.qty];
+    record.qtyPrev = invalidHandle;
+    record.qtyNext = qtyList.head;
+    if (qtyList.head != invalidHandle) {
+        records[qtyList.head].qtyPrev = handle;
+    }
+    qtyList.head = handle;
+    ++qtyList.size;
+
+    addToAggregate(record, side);
+}
+
+// Helper function to tell whether an order sits in its security's columns yet
+bool OrderBook::isLinked(OrderHandle handle) const {
+    const auto& record = records[handle];
+    return record.securityId < securityColumns.size() &&
+           record.securityRow < securityColumns[record.securityId].size() &&
+           securityColumns[record.securityId].handle[record.securityRow] == handle;
+}
+
+// Helper function to update mappings when an order is canceled
+void OrderBook::updateMappingsOnCancel(OrderHandle handle) {
+    auto& record = records[handle];
+    auto& userList = userOrders[record.user];
+    if (record.userPrev != invalidHandle) {
+        records[record.userPrev].userNext = record.userNext;
+    } else {
+        userList.head = record.userNext;
+    }
+    if (record.userNext != invalidHandle) {
+        records[record.userNext].userPrev = record.userPrev;
+    }
+    --userList.size;
+
+    unlinkFromSecurity(handle);
+}
+
+// Helper function to unlink orders from their securities on the pool
+void OrderBook::unlinkFromSecuritiesInParallel(const std::vector<OrderHandle>& handles, WorkStealingPool& pool) {
+    // Counting sort by security: each security's orders become one contiguous, still ordered run
+    std::vector<std::size_t> runStart(securityColumns.size() + 1, 0);
+    for (OrderHandle handle : handles) {
+        ++runStart[records[handle].securityId + 1];
+    }
+    std::vector<SymbolId> touched;
+    for (SymbolId secId = 0; secId < securityColumns.size(); ++secId) {
+        if (runStart[secId + 1] > 0) {
+            touched.push_back(secId);
+        }
+        runStart[secId + 1] += runStart[secId];
+    }
+    std::vector<OrderHandle> bySecurity(handles.size());
+    std::vector<std::size_t> fill(runStart.begin(), runStart.end() - 1);
+    for (OrderHandle handle : handles) {
+        bySecurity[fill[records[handle].securityId]++] = handle;
+    }
+
+    // A security's columns, qty levels and totals are its own; only the arena is shared,
+    // when emptied qty levels and companies hand their nodes back
+    arena.setShared(true);
+    pool.run(touched.size(), [&](std::size_t job) {
+        SymbolId secId = touched[job];
+        for (std::size_t i = runStart[secId]; i < runStart[secId + 1]; ++i) {
+            unlinkFromSecurity(bySecurity[i]);
+        }
+    });
+    arena.setShared(false);
+}
+
+// Helper function to remove an order from its security's columns and qty index
+void OrderBook::unlinkFromSecurity(OrderHandle handle) {
+    auto& record = records[handle];
+    auto& columns = securityColumns[record.securityId];
+    std::uint32_t row = record.securityRow;
+    OrderSide side = columns.side[row];
+
+    // Move the last row into the hole so the columns stay packed
+    std::size_t last = columns.size() - 1;
+    if (row != last) {
+        columns.qty[row] = columns.qty[last];
+        columns.side[row] = columns.side[last];
+        columns.handle[row] = columns.handle[last];
+        records[columns.handle[row]].securityRow = row;
+    }
+    columns.qty.pop_back();
+    columns.side.pop_back();
+    columns.handle.pop_back();
+
+    auto& levels = securityQtyLevels[record.securityId];
+    auto level = levels.find(record.qty);
+    if (record.qtyPrev != invalidHandle) {
+        records[record.qtyPrev].qtyNext = record.qtyNext;
+    } else {
+        level->second.head = record.qtyNext;
+    }
+    if (record.qtyNext != invalidHandle) {
+        records[record.qtyNext].qtyPrev = record.qtyPrev;
+    }
+    // Drop the qty level once its last order is gone, so walks never meet empty levels
+    if (--level->second.size == 0) {
+        levels.erase(level);
+    }
+
+    removeFromAggregate(record, side);
+}
+
+// Helper function to account for an order in its security's matching totals
+void OrderBook::addToAggregate(const OrderRecord& record, OrderSide side) {
+    // A qty-0 order adds nothing, and must not keep a company row alive that removal may already have dropped
+    if (side == OrderSide::Other || record.qty == 0) {
+        return;
+    }
+    auto& aggregate = securityAggregates[record.securityId];
+    auto [companyIter, inserted] = aggregate.companyRow.try_emplace(record.company,
+                                                                   static_cast<std::uint32_t>(aggregate.company.size()));
+    if (inserted) {
+        aggregate.company.push_back(record.company);
+        aggregate.buy.push_back(0);
+        aggregate.sell.push_back(0);
+    }
+    std::uint32_t row = companyIter->second;
+    if (side == OrderSide::Buy) {
+        aggregate.buy[row] += record.qty;
+        aggregate.totalBuy += record.qty;
+    } else {
+        aggregate.sell[row] += record.qty;
+        aggregate.totalSell += record.qty;
+    }
+}
+
+// Helper function to take an order out of its security's matching totals
+void OrderBook::removeFromAggregate(const OrderRecord& record, OrderSide side) {
+    // Qty-0 orders were never added, and their company may have no row left
+    if (side == OrderSide::Other || record.qty == 0) {
+        return;
+    }
+    auto& aggregate = securityAggregates[record.securityId];
+    auto companyIter = aggregate.companyRow.find(record.company);
+    std::uint32_t row = companyIter->second;
+    if (side == OrderSide::Buy) {
+        aggregate.buy[row] -= record.qty;
+        aggregate.totalBuy -= record.qty;
+    } else {
+        aggregate.sell[row] -= record.qty;
+        aggregate.totalSell -= record.qty;
+    }
+    // Keep only companies with resting quantity so queries stay proportional to active companies
+    if (aggregate.buy[row] == 0 && aggregate.sell[row] == 0) {
+        aggregate.companyRow.erase(companyIter);
+        std::size_t last = aggregate.company.size() - 1;
+        if (row != last) {
+            aggregate.company[row] = aggregate.company[last];
+            aggregate.buy[row] = aggregate.buy[last];
+            aggregate.sell[row] = aggregate.sell[last];
+            aggregate.companyRow[aggregate.company[row]] = row;
+        }
+        aggregate.company.pop_back();
+        aggregate.buy.pop_back();
+        aggregate.sell.pop_back();
+    }
+}
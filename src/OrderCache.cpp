@@ -1,155 +1,247 @@
 #include "../include/OrderCache.h"
 #include <algorithm>
 
+OrderCache::OrderCache(std::pmr::memory_resource* upstream)
+    : book(upstream) {}
+
+void OrderCache::reserve(std::size_t expectedOrders) {
+    std::lock_guard<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    book.reserve(expectedOrders);
+}
+
+std::size_t OrderCache::capacity() const {
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);  // Shared lock, queries run alongside each other
+    return book.capacity();
+}
+
 void OrderCache::addOrder(Order order) {
-    std::lock_guard<std::mutex> lock(cacheMutex);  // Lock mutex for thread safety
-    orders[order.orderId()] = order;
-    updateMappingsOnAdd(order);
+    OpTimer timer(activeStats(), CacheOp::AddOrder);
+    std::unique_lock<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    timer.locked();
+    // Journal first, so a failed write leaves the book unchanged
+    if (persistence) {
+        persistence->logAdd(order);
+    }
+    book.addOrder(order);
+    ORDERCACHE_LOG_EVENT(eventLog, EventType::Add, order.orderId(), order.securityId(), order.side(), order.qty());
+    checkpointIfDue(lock);
 }
 
 void OrderCache::cancelOrder(const std::string& orderId) {
-    std::lock_guard<std::mutex> lock(cacheMutex);  // Lock mutex for thread safety
-    auto orderIter = orders.find(orderId);
-    if (orderIter != orders.end()) {
-        updateMappingsOnCancel(orderIter->second);
-        orders.erase(orderIter);
+    OpTimer timer(activeStats(), CacheOp::CancelOrder);
+    std::unique_lock<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    timer.locked();
+    // Journal first, and only cancels that remove an order
+    if (persistence && book.contains(orderId)) {
+        persistence->logCancel(orderId);
     }
+    book.cancelOrder(orderId);
+    ORDERCACHE_LOG_EVENT(eventLog, EventType::Cancel, orderId);
+    checkpointIfDue(lock);
 }
 
-void OrderCache::cancelOrdersForUser(const std::string& user) {
-    std::lock_guard<std::mutex> lock(cacheMutex);  // Lock mutex for thread safety
-    
-    // Find the user orders in the map
-    auto userOrdersIter = userOrders.find(user);
-    if (userOrdersIter != userOrders.end()) {
-        // Iterate over all order IDs for this user
-        for (const auto& orderId : userOrdersIter->second) {
-            // Find and remove the order from the orders map
-            auto orderIter = orders.find(orderId);
-            if (orderIter != orders.end()) {
-                // Remove the order from the securityOrders map
-                auto& secOrdersList = securityOrders[orderIter->second.securityId()];
-                secOrdersList.erase(std::remove(secOrdersList.begin(), secOrdersList.end(), orderId), secOrdersList.end());
-                if (secOrdersList.empty()) {
-                    securityOrders.erase(orderIter->second.securityId());
-                }
-                // Remove the order from the orders map
-                orders.erase(orderIter);
-            }
+void OrderCache::addOrders(std::vector<Order> orders) {
+    OpTimer timer(activeStats(), CacheOp::AddOrders);
+    std::unique_lock<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    timer.locked();
+    if (persistence) {
+        for (const auto& order : orders) {
+            persistence->logAdd(order);
         }
-        // Finally, remove the user from the userOrders map
-        userOrders.erase(userOrdersIter);
     }
+    book.addOrders(orders);
+    for (const auto& order : orders) {
+        ORDERCACHE_LOG_EVENT(eventLog, EventType::Add, order.orderId(), order.securityId(), order.side(), order.qty());
+    }
+    checkpointIfDue(lock);
+}
+
+void OrderCache::cancelOrders(const std::vector<std::string>& orderIds) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrders);
+    std::unique_lock<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    timer.locked();
+    for (const auto& orderId : orderIds) {
+        if (persistence && book.contains(orderId)) {
+            persistence->logCancel(orderId);
+        }
+        book.cancelOrder(orderId);
+        ORDERCACHE_LOG_EVENT(eventLog, EventType::Cancel, orderId);
+    }
+    checkpointIfDue(lock);
 }
 
+void OrderCache::cancelOrdersForUser(const std::string& user) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrdersForUser);
+    std::unique_lock<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    timer.locked();
+    if (persistence) {
+        persistence->logCancelForUser(user);
+    }
+    std::size_t cancelled = book.cancelOrdersForUser(user, nullptr, pool.get());
+    ORDERCACHE_LOG_EVENT(eventLog, EventType::CancelForUser, user, std::string(), std::string(), 0,
+                         static_cast<std::uint32_t>(cancelled));
+    checkpointIfDue(lock);
+}
 
 void OrderCache::cancelOrdersForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) {
-    std::lock_guard<std::mutex> lock(cacheMutex);  // Lock mutex for thread safety
-    auto securityOrdersIter = securityOrders.find(securityId);
-    if (securityOrdersIter != securityOrders.end()) {
-        for (const auto& orderId : securityOrdersIter->second) {
-            auto orderIter = orders.find(orderId);
-            if (orderIter != orders.end() && orderIter->second.qty() >= minQty) {
-                updateMappingsOnCancel(orderIter->second);
-                orders.erase(orderIter);
-            }
-        }
+    OpTimer timer(activeStats(), CacheOp::CancelOrdersForSecIdWithMinimumQty);
+    std::unique_lock<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    timer.locked();
+    if (persistence) {
+        persistence->logCancelForSecIdWithMinimumQty(securityId, minQty);
     }
+    std::size_t cancelled = book.cancelOrdersForSecIdWithMinimumQty(securityId, minQty);
+    ORDERCACHE_LOG_EVENT(eventLog, EventType::CancelForSecIdWithMinimumQty, std::string(), securityId, std::string(),
+                         minQty, static_cast<std::uint32_t>(cancelled));
+    checkpointIfDue(lock);
 }
 
 unsigned int OrderCache::getMatchingSizeForSecurity(const std::string& securityId) {
-    std::lock_guard<std::mutex> lock(cacheMutex);  // Lock mutex for thread safety
-    unsigned int totalMatchedQty = 0;
-
-    // Vectors to hold pointers to Buy and Sell orders for matching
-    std::vector<Order*> buyOrders;
-    std::vector<Order*> sellOrders;
-
-    // Retrieve orders related to the specified security ID
-    auto securityOrdersIter = securityOrders.find(securityId);
-    if (securityOrdersIter != securityOrders.end()) {
-        for (const auto& orderId : securityOrdersIter->second) {
-            auto& order = orders[orderId];
-            if (order.side() == "Buy") {
-                buyOrders.push_back(&order);
-            } else if (order.side() == "Sell") {
-                sellOrders.push_back(&order);
-            }
-        }
+    OpTimer timer(activeStats(), CacheOp::GetMatchingSizeForSecurity);
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);  // Shared lock, queries run alongside each other
+    timer.locked();
+    unsigned int matchingSize = book.getMatchingSizeForSecurity(securityId);
+    ORDERCACHE_LOG_EVENT(eventLog, EventType::Match, std::string(), securityId, std::string(), 0, matchingSize);
+    return matchingSize;
+}
 
-        // Sort buy and sell orders by their order IDs to maintain a deterministic matching process
-        std::sort(buyOrders.begin(), buyOrders.end(), [](const Order* a, const Order* b) {
-            return a->orderId() < b->orderId();
-        });
-        std::sort(sellOrders.begin(), sellOrders.end(), [](const Order* a, const Order* b) {
-            return a->orderId() < b->orderId();
-        });
+std::vector<SecurityMatch> OrderCache::getMatchingSizeForAllSecurities() const {
+    OpTimer timer(activeStats(), CacheOp::GetMatchingSizeForAllSecurities);
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);  // Shared lock, queries run alongside each other
+    timer.locked();
+    return book.getMatchingSizeForAllSecurities(pool.get());
+}
+
+void OrderCache::setParallelism(std::size_t threads) {
+    pool = threads > 1 ? std::make_unique<WorkStealingPool>(threads) : nullptr;
+}
+
+RecoveryStats OrderCache::enablePersistence(const std::string& directory, const JournalOptions& options) {
+    std::lock_guard<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    auto journal = std::make_unique<OrderPersistence>(directory, options);
+    RecoveryStats stats = journal->recover(book);
+    persistence = std::move(journal);
+    return stats;
+}
+
+void OrderCache::checkpoint() {
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+    writeCheckpoint(false);
+}
 
-        // Attempt to match Buy and Sell orders
-        for (auto& buyOrder : buyOrders) {
-            for (auto& sellOrder : sellOrders) {
-                // Skip matching if both orders are from the same company
-                if (buyOrder->company() == sellOrder->company()) {
-                    continue; // Skip matching orders from the same company
-                }
-
-                // Calculate the matchable quantity between the current Buy and Sell orders
-                unsigned int matchQty = std::min(buyOrder->qty(), sellOrder->qty());
-
-                // If a match is possible, allocate the quantity and update the matched total
-                if (matchQty > 0) {
-                    totalMatchedQty += matchQty;
-
-                    // Update the quantities of the orders after matching
-                    buyOrder->setQty(buyOrder->qty() - matchQty);
-                    sellOrder->setQty(sellOrder->qty() - matchQty);
-
-                    // Print debug information for matches
-                    std::cout << "Matched " << matchQty << " between Buy " << buyOrder->orderId()
-                              << " (remaining " << buyOrder->qty() << ") and Sell " 
-                              << sellOrder->orderId() << " (remaining " << sellOrder->qty() << ")\n";
-
-                    // Stop matching the current buy order if fully matched
-                    if (buyOrder->qty() == 0) {
-                        break;
-                    }
-                }
-            }
+// Helper function to write a snapshot once the journal has grown enough since the last one
+void OrderCache::checkpointIfDue(std::unique_lock<FairSharedMutex>& lock) {
+    if (!persistence || !persistence->checkpointDue()) {
+        return;
+    }
+    lock.unlock();
+    // A checkpoint already in progress resets the count, no need to wait for it
+    std::unique_lock<std::mutex> checkpointLock(checkpointMutex, std::try_to_lock);
+    if (checkpointLock) {
+        writeCheckpoint(true);
+    }
+}
+
+// Helper function to capture a snapshot under the shared lock and write it after; needs checkpointMutex
+void OrderCache::writeCheckpoint(bool onlyIfDue) {
+    if (!persistence) {
+        return;
+    }
+    std::vector<char> image;
+    {
+        // Shared lock keeps writers out, so the image matches the start of the new journal segment
+        std::shared_lock<FairSharedMutex> lock(cacheMutex);
+        if (onlyIfDue && !persistence->checkpointDue()) {
+            return;
         }
+        image = persistence->captureSnapshot(book);
     }
+    persistence->commitSnapshot(image);
+}
 
-    return totalMatchedQty;
+void OrderCache::syncJournal() {
+    std::lock_guard<FairSharedMutex> lock(cacheMutex);  // Exclusive lock, the journal buffer is shared with writers
+    if (persistence) {
+        persistence->sync();
+    }
 }
 
-std::vector<Order> OrderCache::getAllOrders() const {
-    std::lock_guard<std::mutex> lock(cacheMutex);  // Lock mutex for thread safety
-    std::vector<Order> allOrders;
-    for (const auto& [orderId, order] : orders) {
-        allOrders.push_back(order);
+QtyTotals OrderCache::getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) const {
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);  // Shared lock, queries run alongside each other
+    return book.getQtyTotalsForSecIdWithMinimumQty(securityId, minQty);
+}
+
+bool OrderCache::enableEventLog(const std::string& path, const EventLogOptions& options) {
+#if ORDERCACHE_EVENT_LOG
+    auto log = std::make_shared<EventLog>(path, options);
+    std::lock_guard<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    eventLog = std::move(log);
+    return true;
+#else
+    (void)path;
+    (void)options;
+    return false;
+#endif
+}
+
+void OrderCache::flushEventLog() {
+    // The lock is held only to take a reference; waiting for the drain under it would stall writers
+    std::shared_ptr<EventLog> log;
+    {
+        std::shared_lock<FairSharedMutex> lock(cacheMutex);  // Shared lock, queries run alongside each other
+        log = eventLog;
+    }
+    if (log) {
+        log->flush();
     }
-    std::sort(allOrders.begin(), allOrders.end(), [](const Order& a, const Order& b) {
-        return a.orderId() < b.orderId();
-    });
-    return allOrders;
 }
 
-// Helper function to update mappings when an order is added
-void OrderCache::updateMappingsOnAdd(const Order& order) {
-    userOrders[order.user()].push_back(order.orderId());
-    securityOrders[order.securityId()].push_back(order.orderId());
+void OrderCache::setStatsEnabled(bool enabled) {
+    std::lock_guard<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    if (enabled && !stats) {
+        stats = std::make_unique<CacheStats>();
+    }
+    statsEnabled.store(enabled, std::memory_order_release);
 }
 
-// Helper function to update mappings when an order is canceled
-void OrderCache::updateMappingsOnCancel(const Order& order) {
-    auto& userOrderIds = userOrders[order.user()];
-    userOrderIds.erase(std::remove(userOrderIds.begin(), userOrderIds.end(), order.orderId()), userOrderIds.end());
-    if (userOrderIds.empty()) {
-        userOrders.erase(order.user());
+CacheStatsSnapshot OrderCache::statsSnapshot() const {
+    CacheStatsSnapshot snapshot;
+    std::shared_lock<FairSharedMutex> lock(cacheMutex);  // Shared lock, queries run alongside each other
+    if (stats) {
+        snapshot.operations = stats->operations();
     }
+    snapshot.book = book.stats();
+    return snapshot;
+}
+
+void OrderCache::setOrderedViewEnabled(bool enabled) {
+    std::lock_guard<FairSharedMutex> lock(cacheMutex);  // Exclusive lock for writers
+    book.setOrderedViewEnabled(enabled);
+}
 
-    auto& securityOrderIds = securityOrders[order.securityId()];
-    securityOrderIds.erase(std::remove(securityOrderIds.begin(), securityOrderIds.end(), order.orderId()), securityOrderIds.end());
-    if (securityOrderIds.empty()) {
-        securityOrders.erase(order.securityId());
+std::vector<Order> OrderCache::getAllOrders() const {
+    OpTimer timer(activeStats(), CacheOp::GetAllOrders);
+    std::vector<Order> allOrders;
+    bool sorted;
+    {
+        std::shared_lock<FairSharedMutex> lock(cacheMutex);  // Shared lock, held only while copying
+        timer.locked();
+        allOrders.reserve(book.size());
+        // With the ordered view the copy comes out in order ID order already
+        sorted = book.orderedViewEnabled();
+        if (sorted) {
+            book.visitOrdersById([&allOrders](const OrderView& order) {
+                allOrders.push_back(order.toOrder());
+            });
+        } else {
+            book.appendOrders(allOrders);
+        }
     }
+    // The copy is a consistent snapshot; sort it without blocking writers
+    if (!sorted) {
+        std::sort(allOrders.begin(), allOrders.end(), [](const Order& a, const Order& b) {
+            return a.orderId() < b.orderId();
+        });
+    }
+    return allOrders;
 }
@@ -0,0 +1,176 @@
+#include "../include/OrderIdIndex.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+OrderIdIndex::~OrderIdIndex() {
+    release(current);
+    release(previous);
+}
+
+void OrderIdIndex::reserve(std::size_t expected) {
+    std::size_t groups = std::max<std::size_t>(current.groups, 1);
+    while (groups * groupSize - groups * groupSize / 8 < expected) {
+        groups *= 2;
+    }
+    if (groups > current.groups) {
+        grow(groups);
+    }
+}
+
+void OrderIdIndex::insert(std::uint64_t hash, Handle handle) {
+    if (previous.groups != 0) {
+        migrate(migrateGroupsPerStep);
+    }
+    if (current.used >= maxUsed(current)) {
+        // Mostly tombstones: a table of the same size cleans them up
+        bool crowded = current.size >= maxUsed(current) / 2;
+        grow(current.groups == 0 ? 1 : crowded ? current.groups * 2 : current.groups);
+    }
+    place(current, homeOf(hash), controlOf(hash), handle);
+}
+
+bool OrderIdIndex::erase(std::uint64_t hash, Handle handle) {
+    if (previous.groups != 0) {
+        migrate(migrateGroupsPerStep);
+    }
+    std::uint32_t home = homeOf(hash);
+    std::uint8_t control = controlOf(hash);
+    return eraseFrom(current, home, control, handle) ||
+           (previous.size > 0 && eraseFrom(previous, home, control, handle));
+}
+
+HashTableStats OrderIdIndex::stats(std::string name) const {
+    HashTableStats stats;
+    stats.name = std::move(name);
+    stats.entries = size();
+    stats.buckets = (current.groups + previous.groups) * groupSize;
+    stats.loadFactor = stats.buckets ? static_cast<float>(stats.entries) / stats.buckets : 0.0f;
+    stats.maxLoadFactor = 0.875f;
+    for (const Table* table : {&current, &previous}) {
+        stats.usedBuckets += table->used;
+        std::size_t groupMask = table->groups - 1;
+        for (std::size_t slot = 0; slot < table->groups * groupSize; ++slot) {
+            if (!(table->control[slot] & 0x80)) {
+                continue;
+            }
+            // Replay the entry's probe sequence up to the group it landed in
+            std::size_t target = slot / groupSize;
+            std::size_t group = table->slots[slot].home & groupMask;
+            std::size_t probed = 1;
+            for (std::size_t step = 1; group != target; ++step) {
+                group = (group + step) & groupMask;
+                ++probed;
+            }
+            stats.collidedEntries += probed > 1;
+            stats.longestChain = std::max(stats.longestChain, probed);
+        }
+    }
+    return stats;
+}
+
+// Helper function to allocate a table of empty groups
+OrderIdIndex::Table OrderIdIndex::allocate(std::size_t groups) {
+    // calloc hands out fresh zeroed pages for large tables, so allocating one does not touch it
+    Table table;
+    table.groups = groups;
+    table.control = static_cast<std::uint8_t*>(std::calloc(groups * groupSize, 1));
+    table.slots = static_cast<Slot*>(std::malloc(groups * groupSize * sizeof(Slot)));
+    if (!table.control || !table.slots) {
+        std::free(table.control);
+        std::free(table.slots);
+        throw std::bad_alloc();
+    }
+    return table;
+}
+
+// Helper function to free a table's storage
+void OrderIdIndex::release(Table& table) {
+    std::free(table.control);
+    std::free(table.slots);
+    table = Table();
+}
+
+// Helper function to put an entry into the first free slot of its probe sequence
+void OrderIdIndex::place(Table& table, std::uint32_t home, std::uint8_t control, Handle handle) {
+    std::size_t groupMask = table.groups - 1;
+    std::size_t group = home & groupMask;
+    for (std::size_t step = 1;; ++step) {
+        std::uint8_t* bytes = table.control + group * groupSize;
+        if (std::uint32_t free = matchFree(bytes)) {
+            std::size_t slot = group * groupSize + lowestBit(free);
+            table.used += table.control[slot] == emptyByte;
+            ++table.size;
+            table.control[slot] = control;
+            table.slots[slot] = {handle, home};
+            return;
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+// Helper function to erase an entry from one table
+bool OrderIdIndex::eraseFrom(Table& table, std::uint32_t home, std::uint8_t control, Handle handle) {
+    if (table.groups == 0) {
+        return false;
+    }
+    std::size_t groupMask = table.groups - 1;
+    std::size_t group = home & groupMask;
+    for (std::size_t step = 1;; ++step) {
+        std::uint8_t* bytes = table.control + group * groupSize;
+        for (std::uint32_t candidates = matchByte(bytes, control); candidates; candidates &= candidates - 1) {
+            std::size_t slot = group * groupSize + lowestBit(candidates);
+            if (table.slots[slot].handle == handle) {
+                // A group that still has an empty slot never sent a probe further, so the slot can
+                // become empty again; otherwise a tombstone keeps later entries reachable
+                if (matchByte(bytes, emptyByte)) {
+                    table.control[slot] = emptyByte;
+                    --table.used;
+                } else {
+                    table.control[slot] = deletedByte;
+                }
+                --table.size;
+                return true;
+            }
+        }
+        if (matchByte(bytes, emptyByte)) {
+            return false;
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+// Helper function to switch to a new table and start draining the current one
+void OrderIdIndex::grow(std::size_t groups) {
+    // Growing again before the last growth finished is rare; finish it in one go
+    if (previous.groups != 0) {
+        migrate(previous.groups);
+    }
+    Table next = allocate(groups);
+    if (current.size > 0) {
+        previous = current;
+        migrateCursor = 0;
+    } else {
+        release(current);
+    }
+    current = next;
+}
+
+// Helper function to move part of the old table into the new one
+void OrderIdIndex::migrate(std::size_t groups) {
+    std::size_t end = std::min(previous.groups, migrateCursor + groups);
+    for (std::size_t slot = migrateCursor * groupSize; slot < end * groupSize && previous.size > 0; ++slot) {
+        std::uint8_t control = previous.control[slot];
+        if (control & 0x80) {
+            place(current, previous.slots[slot].home, control, previous.slots[slot].handle);
+            // Moved entries must not turn up again when a lookup falls back to the old table
+            previous.control[slot] = deletedByte;
+            --previous.size;
+        }
+    }
+    migrateCursor = end;
+    if (migrateCursor == previous.groups || previous.size == 0) {
+        release(previous);
+        migrateCursor = 0;
+    }
+}
@@ -0,0 +1,588 @@
+#include "../include/OrderPersistence.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    enum class JournalRecordType : std::uint8_t {
+        Add = 1,
+        Cancel = 2,
+        CancelForUser = 3,
+        CancelForSecIdWithMinimumQty = 4,
+    };
+
+    // Size of the [length][crc] frame in front of every journal record body.
+    constexpr std::size_t frameBytes = 8;
+
+    // Snapshot orders handed to OrderBook::addOrders at once while loading.
+    constexpr std::size_t snapshotLoadBatch = 4096;
+
+    constexpr char snapshotMagic[8] = {'O', 'C', 'S', 'N', 'A', 'P', '0', '1'};
+    constexpr std::uint32_t snapshotVersion = 1;
+    // Written in native byte order; a mismatch on load means the file came from another architecture.
+    constexpr std::uint32_t endianTag = 0x01020304;
+
+    struct SnapshotHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t endian;
+        std::uint64_t journalSegment;
+        std::uint64_t symbolCount;
+        std::uint64_t orderCount;
+        std::uint64_t stringBytes;
+    };
+
+    struct SnapshotSymbol {
+        std::uint64_t offset;
+        std::uint32_t length;
+        std::uint32_t reserved;
+    };
+
+    struct SnapshotOrder {
+        std::uint64_t idOffset;
+        std::uint32_t idLength;
+        std::uint32_t securityId;
+        std::uint32_t side;
+        std::uint32_t user;
+        std::uint32_t company;
+        std::uint32_t qty;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 48, "snapshot header layout");
+    static_assert(sizeof(SnapshotSymbol) == 16, "snapshot symbol layout");
+    static_assert(sizeof(SnapshotOrder) == 32, "snapshot order layout");
+
+    // CRC-32 (IEEE 802.3, reflected), table driven.
+    std::uint32_t crc32(const char* data, std::size_t size) {
+        static const auto table = [] {
+            std::array<std::uint32_t, 256> entries{};
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[i] = c;
+            }
+            return entries;
+        }();
+        std::uint32_t crc = 0xFFFFFFFFu;
+        for (std::size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    void appendBytes(std::vector<char>& out, const void* data, std::size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    void appendU32(std::vector<char>& out, std::uint32_t value) {
+        appendBytes(out, &value, sizeof(value));
+    }
+
+    void appendString(std::vector<char>& out, std::string_view value) {
+        appendU32(out, static_cast<std::uint32_t>(value.size()));
+        appendBytes(out, value.data(), value.size());
+    }
+
+    // Bounds-checked reader over a journal record body.
+    class BodyReader {
+        public:
+            BodyReader(const char* begin, const char* end) : cursor(begin), end(end) {}
+
+            bool readU8(std::uint8_t& value) { return read(&value, sizeof(value)); }
+            bool readU32(std::uint32_t& value) { return read(&value, sizeof(value)); }
+
+            bool readString(std::string& value) {
+                std::uint32_t length;
+                if (!readU32(length) || static_cast<std::size_t>(end - cursor) < length) {
+                    return false;
+                }
+                value.assign(cursor, length);
+                cursor += length;
+                return true;
+            }
+
+        private:
+            const char* cursor;
+            const char* end;
+
+            bool read(void* value, std::size_t size) {
+                if (static_cast<std::size_t>(end - cursor) < size) {
+                    return false;
+                }
+                std::memcpy(value, cursor, size);
+                cursor += size;
+                return true;
+            }
+    };
+
+    // Read-only view of a whole file: memory-mapped where available, read into memory otherwise.
+    class MappedFile {
+        public:
+            explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+                std::ifstream in(path, std::ios::binary);
+                if (!in) {
+                    throw std::runtime_error("cannot open " + path);
+                }
+                fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                bytes = fallback.data();
+                length = fallback.size();
+#else
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw std::runtime_error("cannot open " + path);
+                }
+                struct stat info;
+                if (::fstat(fd, &info) != 0) {
+                    ::close(fd);
+                    throw std::runtime_error("cannot stat " + path);
+                }
+                length = static_cast<std::size_t>(info.st_size);
+                if (length > 0) {
+                    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped == MAP_FAILED) {
+                        ::close(fd);
+                        throw std::runtime_error("cannot map " + path);
+                    }
+                    bytes = static_cast<const char*>(mapped);
+                }
+                ::close(fd);
+#endif
+            }
+
+            ~MappedFile() {
+#if !defined(_WIN32)
+                if (bytes) {
+                    ::munmap(const_cast<char*>(bytes), length);
+                }
+#endif
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            const char* data() const { return bytes; }
+            std::size_t size() const { return length; }
+
+        private:
+            const char* bytes = nullptr;
+            std::size_t length = 0;
+#if defined(_WIN32)
+            std::vector<char> fallback;
+#endif
+    };
+
+    // Flushes stdio buffers and asks the OS to put the file on stable storage.
+    void syncFile(std::FILE* file) {
+        std::fflush(file);
+#if defined(_WIN32)
+        _commit(_fileno(file));
+#else
+        ::fsync(::fileno(file));
+#endif
+    }
+
+    // Makes a rename inside the directory durable.
+    void syncDirectory(const std::string& directory) {
+#if !defined(_WIN32)
+        int fd = ::open(directory.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+#else
+        (void)directory;
+#endif
+    }
+}
+
+OrderPersistence::OrderPersistence(std::string directory, JournalOptions options)
+    : directory(std::move(directory)), options(options) {
+    fs::create_directories(this->directory);
+}
+
+OrderPersistence::~OrderPersistence() {
+    if (journal) {
+        sync();
+        std::fclose(journal);
+    }
+}
+
+RecoveryStats OrderPersistence::recover(OrderBook& book) {
+    RecoveryStats stats;
+    std::uint64_t firstSegment = 0;
+    if (fs::exists(snapshotPath())) {
+        firstSegment = loadSnapshot(book, stats);
+    }
+
+    std::uint64_t lastSegment = firstSegment;
+    for (std::uint64_t segment : listSegments()) {
+        if (segment >= firstSegment) {
+            replaySegment(segment, book, stats);
+        }
+        lastSegment = std::max(lastSegment, segment);
+    }
+
+    // Never append to a segment that may end in a torn record
+    openSegment(lastSegment + 1);
+    recordsSinceSnapshot = stats.journalRecords;
+    return stats;
+}
+
+void OrderPersistence::logAdd(const Order& order) {
+    std::size_t bodyStart = buffer.size();
+    buffer.resize(bodyStart + frameBytes);
+    buffer.push_back(static_cast<char>(JournalRecordType::Add));
+    appendString(buffer, order.orderId());
+    appendString(buffer, order.securityId());
+    appendString(buffer, order.side());
+    appendU32(buffer, order.qty());
+    appendString(buffer, order.user());
+    appendString(buffer, order.company());
+    finishRecord(bodyStart);
+}
+
+void OrderPersistence::logCancel(const std::string& orderId) {
+    std::size_t bodyStart = buffer.size();
+    buffer.resize(bodyStart + frameBytes);
+    buffer.push_back(static_cast<char>(JournalRecordType::Cancel));
+    appendString(buffer, orderId);
+    finishRecord(bodyStart);
+}
+
+void OrderPersistence::logCancelForUser(const std::string& user) {
+    std::size_t bodyStart = buffer.size();
+    buffer.resize(bodyStart + frameBytes);
+    buffer.push_back(static_cast<char>(JournalRecordType::CancelForUser));
+    appendString(buffer, user);
+    finishRecord(bodyStart);
+}
+
+void OrderPersistence::logCancelForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) {
+    std::size_t bodyStart = buffer.size();
+    buffer.resize(bodyStart + frameBytes);
+    buffer.push_back(static_cast<char>(JournalRecordType::CancelForSecIdWithMinimumQty));
+    appendString(buffer, securityId);
+    appendU32(buffer, minQty);
+    finishRecord(bodyStart);
+}
+
+void OrderPersistence::sync() {
+    if (!journal) {
+        return;
+    }
+    flushBuffer();
+    syncFile(journal);
+    unsyncedRecords = 0;
+}
+
+std::vector<char> OrderPersistence::captureSnapshot(const OrderBook& book) {
+    // The snapshot is the state at the start of a fresh segment
+    openSegment(journalSegment + 1);
+    snapshotSegment = journalSegment;
+    recordsSinceSnapshot = 0;
+
+    // Intern every string field once; order entries then refer to symbols by index
+    std::unordered_map<std::string_view, std::uint32_t> symbolIds;
+    std::vector<std::string_view> symbols;
+    std::vector<std::array<std::uint32_t, 5>> orderSymbols;
+    std::vector<std::string_view> orderIds;
+    orderSymbols.reserve(book.size());
+    orderIds.reserve(book.size());
+    std::uint64_t stringBytes = 0;
+
+    auto symbolFor = [&](std::string_view value) {
+        auto [iter, inserted] = symbolIds.try_emplace(value, static_cast<std::uint32_t>(symbols.size()));
+        if (inserted) {
+            symbols.push_back(value);
+            stringBytes += value.size();
+        }
+        return iter->second;
+    };
+    book.visitOrders([&](const OrderView& order) {
+        orderIds.push_back(order.orderId);
+        stringBytes += order.orderId.size();
+        orderSymbols.push_back({symbolFor(order.securityId), symbolFor(order.side), symbolFor(order.user),
+                                symbolFor(order.company), order.qty});
+    });
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.endian = endianTag;
+    header.journalSegment = snapshotSegment;
+    header.symbolCount = symbols.size();
+    header.orderCount = orderIds.size();
+    header.stringBytes = stringBytes;
+
+    std::vector<char> image(sizeof(SnapshotHeader) + symbols.size() * sizeof(SnapshotSymbol) +
+                            orderIds.size() * sizeof(SnapshotOrder) + stringBytes);
+    char* cursor = image.data();
+    std::memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+
+    char* strings = image.data() + image.size() - stringBytes;
+    std::uint64_t stringOffset = 0;
+    auto storeString = [&](std::string_view value) {
+        std::memcpy(strings + stringOffset, value.data(), value.size());
+        std::uint64_t offset = stringOffset;
+        stringOffset += value.size();
+        return offset;
+    };
+
+    for (std::string_view symbol : symbols) {
+        SnapshotSymbol entry{storeString(symbol), static_cast<std::uint32_t>(symbol.size()), 0};
+        std::memcpy(cursor, &entry, sizeof(entry));
+        cursor += sizeof(entry);
+    }
+    for (std::size_t i = 0; i < orderIds.size(); ++i) {
+        const auto& fields = orderSymbols[i];
+        SnapshotOrder entry{storeString(orderIds[i]), static_cast<std::uint32_t>(orderIds[i].size()),
+                            fields[0], fields[1], fields[2], fields[3], fields[4]};
+        std::memcpy(cursor, &entry, sizeof(entry));
+        cursor += sizeof(entry);
+    }
+    return image;
+}
+
+void OrderPersistence::commitSnapshot(const std::vector<char>& image) {
+    // Write aside and rename, so a crash leaves either the old or the new snapshot
+    std::string temporaryPath = snapshotPath() + ".tmp";
+    std::FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("cannot create " + temporaryPath);
+    }
+    bool written = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+    syncFile(file);
+    std::fclose(file);
+    if (!written) {
+        fs::remove(temporaryPath);
+        throw std::runtime_error("cannot write " + temporaryPath);
+    }
+    fs::rename(temporaryPath, snapshotPath());
+    syncDirectory(directory);
+
+    // The journal before the snapshot's segment is no longer needed
+    for (std::uint64_t segment : listSegments()) {
+        if (segment < snapshotSegment) {
+            fs::remove(segmentPath(segment));
+        }
+    }
+}
+
+std::string OrderPersistence::segmentPath(std::uint64_t segment) const {
+    char name[40];
+    std::snprintf(name, sizeof(name), "journal-%016llu.log", static_cast<unsigned long long>(segment));
+    return (fs::path(directory) / name).string();
+}
+
+std::string OrderPersistence::snapshotPath() const {
+    return (fs::path(directory) / "snapshot.bin").string();
+}
+
+std::vector<std::uint64_t> OrderPersistence::listSegments() const {
+    std::vector<std::uint64_t> segments;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() != 28 || name.compare(0, 8, "journal-") != 0 || name.compare(24, 4, ".log") != 0) {
+            continue;
+        }
+        // Stray files that merely look like segments are skipped, not allowed to abort recovery
+        std::uint64_t segment = 0;
+        const char* digits = name.data() + 8;
+        auto [end, error] = std::from_chars(digits, digits + 16, segment);
+        if (error == std::errc() && end == digits + 16) {
+            segments.push_back(segment);
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+void OrderPersistence::openSegment(std::uint64_t segment) {
+    if (journal) {
+        sync();
+        std::fclose(journal);
+        journal = nullptr;
+    }
+    std::string path = segmentPath(segment);
+    journal = std::fopen(path.c_str(), "ab");
+    if (!journal) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    // Each record reaches the file in one write from 'buffer'; stdio buffering would hold it back
+    std::setvbuf(journal, nullptr, _IONBF, 0);
+    journalSegment = segment;
+    syncDirectory(directory);
+}
+
+void OrderPersistence::finishRecord(std::size_t bodyStart) {
+    const char* body = buffer.data() + bodyStart + frameBytes;
+    std::uint32_t bodyLength = static_cast<std::uint32_t>(buffer.size() - bodyStart - frameBytes);
+    std::uint32_t checksum = crc32(body, bodyLength);
+    std::memcpy(buffer.data() + bodyStart, &bodyLength, sizeof(bodyLength));
+    std::memcpy(buffer.data() + bodyStart + sizeof(bodyLength), &checksum, sizeof(checksum));
+
+    // Write every record at once, so only the fsync is batched
+    flushBuffer();
+    ++recordsSinceSnapshot;
+    if (++unsyncedRecords >= options.syncEveryRecords) {
+        sync();
+    }
+}
+
+void OrderPersistence::flushBuffer() {
+    if (!buffer.empty()) {
+        if (std::fwrite(buffer.data(), 1, buffer.size(), journal) != buffer.size()) {
+            throw std::runtime_error("cannot append to " + segmentPath(journalSegment));
+        }
+        buffer.clear();
+    }
+}
+
+std::uint64_t OrderPersistence::loadSnapshot(OrderBook& book, RecoveryStats& stats) const {
+    MappedFile file(snapshotPath());
+    SnapshotHeader header;
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("truncated snapshot " + snapshotPath());
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header.version != snapshotVersion ||
+        header.endian != endianTag ||
+        file.size() != sizeof(header) + header.symbolCount * sizeof(SnapshotSymbol) +
+                       header.orderCount * sizeof(SnapshotOrder) + header.stringBytes) {
+        throw std::runtime_error("unrecognized snapshot " + snapshotPath());
+    }
+
+    const char* symbolTable = file.data() + sizeof(header);
+    const char* orderTable = symbolTable + header.symbolCount * sizeof(SnapshotSymbol);
+    const char* strings = orderTable + header.orderCount * sizeof(SnapshotOrder);
+    auto stringAt = [&](std::uint64_t offset, std::uint32_t length) {
+        if (offset + length > header.stringBytes) {
+            throw std::runtime_error("corrupt snapshot " + snapshotPath());
+        }
+        return std::string(strings + offset, length);
+    };
+
+    // Symbols are materialized once, then shared by all orders that use them
+    std::vector<std::string> symbols;
+    symbols.reserve(header.symbolCount);
+    for (std::uint64_t i = 0; i < header.symbolCount; ++i) {
+        SnapshotSymbol entry;
+        std::memcpy(&entry, symbolTable + i * sizeof(entry), sizeof(entry));
+        symbols.push_back(stringAt(entry.offset, entry.length));
+    }
+
+    // Orders are ingested through the batch path, a bounded chunk at a time
+    book.reserve(book.size() + header.orderCount);
+    std::vector<Order> batch;
+    batch.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(header.orderCount, snapshotLoadBatch)));
+    for (std::uint64_t i = 0; i < header.orderCount; ++i) {
+        SnapshotOrder entry;
+        std::memcpy(&entry, orderTable + i * sizeof(entry), sizeof(entry));
+        if (std::max({entry.securityId, entry.side, entry.user, entry.company}) >= header.symbolCount) {
+            throw std::runtime_error("corrupt snapshot " + snapshotPath());
+        }
+        batch.emplace_back(stringAt(entry.idOffset, entry.idLength), symbols[entry.securityId], symbols[entry.side],
+                           entry.qty, symbols[entry.user], symbols[entry.company]);
+        if (batch.size() == snapshotLoadBatch || i + 1 == header.orderCount) {
+            book.addOrders(batch);
+            batch.clear();
+        }
+    }
+    stats.snapshotOrders = header.orderCount;
+    return header.journalSegment;
+}
+
+void OrderPersistence::replaySegment(std::uint64_t segment, OrderBook& book, RecoveryStats& stats) const {
+    std::string path = segmentPath(segment);
+    std::size_t validBytes = 0;
+    std::size_t fileSize = 0;
+    {
+        MappedFile file(path);
+        fileSize = file.size();
+        const char* data = file.data();
+
+        std::string orderId, securityId, side, user, company;
+        while (fileSize - validBytes >= frameBytes) {
+            std::uint32_t bodyLength, checksum;
+            std::memcpy(&bodyLength, data + validBytes, sizeof(bodyLength));
+            std::memcpy(&checksum, data + validBytes + sizeof(bodyLength), sizeof(checksum));
+            if (fileSize - validBytes - frameBytes < bodyLength) {
+                break;
+            }
+            const char* body = data + validBytes + frameBytes;
+            if (crc32(body, bodyLength) != checksum) {
+                break;
+            }
+
+            BodyReader reader(body, body + bodyLength);
+            std::uint8_t type = 0;
+            std::uint32_t value = 0;
+            bool valid = reader.readU8(type);
+            switch (static_cast<JournalRecordType>(type)) {
+                case JournalRecordType::Add:
+                    valid = valid && reader.readString(orderId) && reader.readString(securityId) &&
+                            reader.readString(side) && reader.readU32(value) && reader.readString(user) &&
+                            reader.readString(company);
+                    if (valid) {
+                        book.addOrder(Order(orderId, securityId, side, value, user, company));
+                    }
+                    break;
+                case JournalRecordType::Cancel:
+                    valid = valid && reader.readString(orderId);
+                    if (valid) {
+                        book.cancelOrder(orderId);
+                    }
+                    break;
+                case JournalRecordType::CancelForUser:
+                    valid = valid && reader.readString(user);
+                    if (valid) {
+                        book.cancelOrdersForUser(user);
+                    }
+                    break;
+                case JournalRecordType::CancelForSecIdWithMinimumQty:
+                    valid = valid && reader.readString(securityId) && reader.readU32(value);
+                    if (valid) {
+                        book.cancelOrdersForSecIdWithMinimumQty(securityId, value);
+                    }
+                    break;
+                default:
+                    valid = false;
+                    break;
+            }
+            if (!valid) {
+                break;
+            }
+            validBytes += frameBytes + bodyLength;
+            ++stats.journalRecords;
+        }
+    }
+
+    // Anything after the last intact record was torn by a crash; drop it for good
+    if (validBytes < fileSize) {
+        fs::resize_file(path, validBytes);
+        stats.truncatedTail = true;
+    }
+}
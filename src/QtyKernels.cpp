@@ -0,0 +1,211 @@
+#include "../include/QtyKernels.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ORDERCACHE_X86_KERNELS 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang compile each kernel for its own instruction set; MSVC accepts the intrinsics as is.
+#if defined(__GNUC__) || defined(__clang__)
+#define ORDERCACHE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ORDERCACHE_TARGET(isa)
+#endif
+
+namespace {
+    QtyTotals totalsAtLeastScalar(const std::uint32_t* qty, std::size_t rows, std::uint32_t minQty) {
+        QtyTotals totals;
+        for (std::size_t i = 0; i < rows; ++i) {
+            bool qualifies = qty[i] >= minQty;
+            totals.orders += qualifies;
+            totals.qty += qualifies ? qty[i] : 0;
+        }
+        return totals;
+    }
+
+    std::uint64_t maxSumScalar(const std::uint64_t* buy, const std::uint64_t* sell, std::size_t rows) {
+        std::uint64_t largest = 0;
+        for (std::size_t i = 0; i < rows; ++i) {
+            largest = std::max(largest, buy[i] + sell[i]);
+        }
+        return largest;
+    }
+
+#if defined(ORDERCACHE_X86_KERNELS)
+    // Sum of the two 64-bit lanes.
+    ORDERCACHE_TARGET("sse4.2")
+    std::uint64_t horizontalSum(__m128i lanes) {
+        std::uint64_t values[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values), lanes);
+        return values[0] + values[1];
+    }
+
+    ORDERCACHE_TARGET("avx2")
+    std::uint64_t horizontalSum(__m256i lanes) {
+        std::uint64_t values[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values), lanes);
+        return values[0] + values[1] + values[2] + values[3];
+    }
+
+    // Sum of the 32-bit counter lanes.
+    ORDERCACHE_TARGET("sse4.2")
+    std::size_t horizontalCount(__m128i lanes) {
+        std::uint32_t values[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values), lanes);
+        return std::size_t(values[0]) + values[1] + values[2] + values[3];
+    }
+
+    ORDERCACHE_TARGET("avx2")
+    std::size_t horizontalCount(__m256i lanes) {
+        std::uint32_t values[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values), lanes);
+        std::size_t count = 0;
+        for (std::uint32_t value : values) {
+            count += value;
+        }
+        return count;
+    }
+
+    // Adds the four 32-bit lanes, widened to 64 bits, onto two 64-bit accumulators.
+    ORDERCACHE_TARGET("sse4.2")
+    __m128i addWidened(__m128i sum, __m128i lanes) {
+        sum = _mm_add_epi64(sum, _mm_cvtepu32_epi64(lanes));
+        return _mm_add_epi64(sum, _mm_cvtepu32_epi64(_mm_unpackhi_epi64(lanes, lanes)));
+    }
+
+    ORDERCACHE_TARGET("avx2")
+    __m256i addWidened(__m256i sum, __m256i lanes) {
+        sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(lanes)));
+        return _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(lanes, 1)));
+    }
+
+    // qty >= minQty is tested as max(qty, minQty) == qty, the unsigned compare SSE4.1 offers.
+    ORDERCACHE_TARGET("sse4.2")
+    QtyTotals totalsAtLeastSSE4(const std::uint32_t* qty, std::size_t rows, std::uint32_t minQty) {
+        const __m128i threshold = _mm_set1_epi32(static_cast<int>(minQty));
+        __m128i sum = _mm_setzero_si128();
+        __m128i count = _mm_setzero_si128();
+        std::size_t i = 0;
+        for (; i + 4 <= rows; i += 4) {
+            __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(qty + i));
+            __m128i mask = _mm_cmpeq_epi32(_mm_max_epu32(lanes, threshold), lanes);
+            sum = addWidened(sum, _mm_and_si128(lanes, mask));
+            // Qualifying lanes are all ones, i.e. -1
+            count = _mm_sub_epi32(count, mask);
+        }
+        QtyTotals totals = totalsAtLeastScalar(qty + i, rows - i, minQty);
+        totals.orders += horizontalCount(count);
+        totals.qty += horizontalSum(sum);
+        return totals;
+    }
+
+    ORDERCACHE_TARGET("avx2")
+    QtyTotals totalsAtLeastAVX2(const std::uint32_t* qty, std::size_t rows, std::uint32_t minQty) {
+        const __m256i threshold = _mm256_set1_epi32(static_cast<int>(minQty));
+        __m256i sum = _mm256_setzero_si256();
+        __m256i count = _mm256_setzero_si256();
+        std::size_t i = 0;
+        for (; i + 8 <= rows; i += 8) {
+            __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(qty + i));
+            __m256i mask = _mm256_cmpeq_epi32(_mm256_max_epu32(lanes, threshold), lanes);
+            sum = addWidened(sum, _mm256_and_si256(lanes, mask));
+            count = _mm256_sub_epi32(count, mask);
+        }
+        QtyTotals totals = totalsAtLeastScalar(qty + i, rows - i, minQty);
+        totals.orders += horizontalCount(count);
+        totals.qty += horizontalSum(sum);
+        return totals;
+    }
+
+    // Unsigned 64-bit max through the signed compare: flipping the sign bit preserves order.
+    ORDERCACHE_TARGET("sse4.2")
+    std::uint64_t maxSumSSE4(const std::uint64_t* buy, const std::uint64_t* sell, std::size_t rows) {
+        const __m128i signBit = _mm_set1_epi64x(static_cast<long long>(1ULL << 63));
+        __m128i largest = signBit;  // 0 with its sign bit flipped
+        std::size_t i = 0;
+        for (; i + 2 <= rows; i += 2) {
+            __m128i sums = _mm_add_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buy + i)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(sell + i)));
+            sums = _mm_xor_si128(sums, signBit);
+            largest = _mm_blendv_epi8(largest, sums, _mm_cmpgt_epi64(sums, largest));
+        }
+        std::uint64_t lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_xor_si128(largest, signBit));
+        return std::max({lanes[0], lanes[1], maxSumScalar(buy + i, sell + i, rows - i)});
+    }
+
+    ORDERCACHE_TARGET("avx2")
+    std::uint64_t maxSumAVX2(const std::uint64_t* buy, const std::uint64_t* sell, std::size_t rows) {
+        const __m256i signBit = _mm256_set1_epi64x(static_cast<long long>(1ULL << 63));
+        __m256i largest = signBit;
+        std::size_t i = 0;
+        for (; i + 4 <= rows; i += 4) {
+            __m256i sums = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(buy + i)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sell + i)));
+            sums = _mm256_xor_si256(sums, signBit);
+            largest = _mm256_blendv_epi8(largest, sums, _mm256_cmpgt_epi64(sums, largest));
+        }
+        std::uint64_t lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), _mm256_xor_si256(largest, signBit));
+        return std::max({lanes[0], lanes[1], lanes[2], lanes[3], maxSumScalar(buy + i, sell + i, rows - i)});
+    }
+
+    bool cpuSupports(KernelIsa isa) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        bool sse42 = (info[2] & (1 << 20)) != 0;
+        // AVX registers are usable only if the OS saves them on context switches
+        bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        bool avx2 = osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+        bool sse42 = __builtin_cpu_supports("sse4.2");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        return isa == KernelIsa::Scalar || (isa == KernelIsa::SSE4 && sse42) || (isa == KernelIsa::AVX2 && avx2);
+    }
+#else
+    bool cpuSupports(KernelIsa isa) {
+        return isa == KernelIsa::Scalar;
+    }
+#endif
+
+    const QtyKernels scalarKernels{KernelIsa::Scalar, totalsAtLeastScalar, maxSumScalar};
+#if defined(ORDERCACHE_X86_KERNELS)
+    const QtyKernels sse4Kernels{KernelIsa::SSE4, totalsAtLeastSSE4, maxSumSSE4};
+    const QtyKernels avx2Kernels{KernelIsa::AVX2, totalsAtLeastAVX2, maxSumAVX2};
+#endif
+}
+
+const QtyKernels* QtyKernels::forIsa(KernelIsa isa) {
+    if (!cpuSupports(isa)) {
+        return nullptr;
+    }
+    switch (isa) {
+#if defined(ORDERCACHE_X86_KERNELS)
+        case KernelIsa::AVX2:
+            return &avx2Kernels;
+        case KernelIsa::SSE4:
+            return &sse4Kernels;
+#endif
+        default:
+            return &scalarKernels;
+    }
+}
+
+const QtyKernels& QtyKernels::best() {
+    static const QtyKernels& kernels = [] () -> const QtyKernels& {
+        for (KernelIsa isa : {KernelIsa::AVX2, KernelIsa::SSE4}) {
+            if (const QtyKernels* candidate = forIsa(isa)) {
+                return *candidate;
+            }
+        }
+        return scalarKernels;
+    }();
+    return kernels;
+}
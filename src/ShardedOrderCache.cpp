@@ -0,0 +1,343 @@
+#include "../include/ShardedOrderCache.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+#include <string_view>
+
+namespace {
+    // Route stripes per shard; order IDs are far more numerous than securities.
+    constexpr std::size_t routeStripesPerShard = 4;
+}
+
+ShardedOrderCache::ShardedOrderCache(std::size_t shardCount)
+    : shards(std::max<std::size_t>(shardCount, 1)),
+      routes(std::max<std::size_t>(shardCount, 1) * routeStripesPerShard) {}
+
+void ShardedOrderCache::setParallelism(std::size_t threads) {
+    pool = threads > 1 ? std::make_unique<WorkStealingPool>(threads) : nullptr;
+}
+
+// Helper function to run per-shard work on the pool, or in shard order without one
+void ShardedOrderCache::forEachShard(const std::function<void(std::size_t)>& work) const {
+    if (pool) {
+        pool->run(shards.size(), work);
+        return;
+    }
+    for (std::size_t shardIndex = 0; shardIndex < shards.size(); ++shardIndex) {
+        work(shardIndex);
+    }
+}
+
+std::size_t ShardedOrderCache::defaultShardCount() {
+    return std::max(1u, std::thread::hardware_concurrency()) * 4;
+}
+
+void ShardedOrderCache::reserve(std::size_t expectedOrders) {
+    // Hashing spreads securities evenly, leave some headroom for skew
+    std::size_t perShard = expectedOrders / shards.size() + expectedOrders / (shards.size() * 4) + 1;
+    for (auto& shard : shards) {
+        std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+        shard.book.reserve(perShard);
+    }
+    for (auto& route : routes) {
+        std::lock_guard<std::mutex> routeLock(route.mutex);
+        route.shardOf.reserve(expectedOrders / routes.size() + 1);
+    }
+}
+
+void ShardedOrderCache::addOrder(Order order) {
+    OpTimer timer(activeStats(), CacheOp::AddOrder);
+    std::uint32_t target = shardFor(order.securityId());
+    auto& route = routeFor(order.orderId());
+    std::lock_guard<std::mutex> routeLock(route.mutex);
+
+    auto [routeIter, inserted] = route.shardOf.try_emplace(order.orderId(), target);
+    if (!inserted && routeIter->second != target) {
+        // The ID is resting under another security's shard; the new order replaces it
+        auto& previous = shards[routeIter->second];
+        std::lock_guard<FairSharedMutex> shardLock(previous.mutex);
+        previous.book.cancelOrder(order.orderId());
+    }
+    routeIter->second = target;
+
+    auto& shard = shards[target];
+    std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+    timer.locked();
+    shard.book.addOrder(order);
+}
+
+void ShardedOrderCache::cancelOrder(const std::string& orderId) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrder);
+    auto& route = routeFor(orderId);
+    std::lock_guard<std::mutex> routeLock(route.mutex);
+
+    auto routeIter = route.shardOf.find(orderId);
+    if (routeIter == route.shardOf.end()) {
+        timer.locked();
+        return;
+    }
+    {
+        auto& shard = shards[routeIter->second];
+        std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+        timer.locked();
+        shard.book.cancelOrder(orderId);
+    }
+    route.shardOf.erase(routeIter);
+}
+
+void ShardedOrderCache::addOrders(std::vector<Order> orders) {
+    OpTimer timer(activeStats(), CacheOp::AddOrders);
+    // Keep only the last order for each ID, it would replace the earlier ones anyway
+    std::vector<std::string> orderIds;
+    orderIds.reserve(orders.size());
+    for (const auto& order : orders) {
+        orderIds.push_back(order.orderId());
+    }
+    std::vector<std::size_t> kept;
+    kept.reserve(orders.size());
+    {
+        std::unordered_set<std::string_view> seen;
+        seen.reserve(orders.size());
+        for (std::size_t i = orders.size(); i-- > 0;) {
+            if (seen.insert(orderIds[i]).second) {
+                kept.push_back(i);
+            }
+        }
+    }
+    std::reverse(kept.begin(), kept.end());
+
+    auto routeLocks = lockStripes(orderIds);
+    timer.locked();
+
+    // Route every order, noting the ones that move away from another shard
+    std::vector<std::vector<Order>> addsByShard(shards.size());
+    std::vector<std::vector<std::string>> movedByShard(shards.size());
+    for (std::size_t i : kept) {
+        std::uint32_t target = shardFor(orders[i].securityId());
+        auto& route = routes[stripeFor(orderIds[i])];
+        auto [routeIter, inserted] = route.shardOf.try_emplace(orderIds[i], target);
+        if (!inserted && routeIter->second != target) {
+            movedByShard[routeIter->second].push_back(orderIds[i]);
+        }
+        routeIter->second = target;
+        addsByShard[target].push_back(std::move(orders[i]));
+    }
+
+    // Apply the batch one shard at a time, still under the stripe locks so routes and shards agree
+    for (std::uint32_t shardIndex = 0; shardIndex < shards.size(); ++shardIndex) {
+        if (addsByShard[shardIndex].empty() && movedByShard[shardIndex].empty()) {
+            continue;
+        }
+        auto& shard = shards[shardIndex];
+        std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+        for (const auto& orderId : movedByShard[shardIndex]) {
+            shard.book.cancelOrder(orderId);
+        }
+        shard.book.addOrders(addsByShard[shardIndex]);
+    }
+}
+
+void ShardedOrderCache::cancelOrders(const std::vector<std::string>& orderIds) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrders);
+    auto routeLocks = lockStripes(orderIds);
+    timer.locked();
+
+    std::vector<std::vector<const std::string*>> cancelsByShard(shards.size());
+    for (const auto& orderId : orderIds) {
+        auto& route = routes[stripeFor(orderId)];
+        auto routeIter = route.shardOf.find(orderId);
+        if (routeIter != route.shardOf.end()) {
+            cancelsByShard[routeIter->second].push_back(&orderId);
+            route.shardOf.erase(routeIter);
+        }
+    }
+
+    for (std::uint32_t shardIndex = 0; shardIndex < shards.size(); ++shardIndex) {
+        if (cancelsByShard[shardIndex].empty()) {
+            continue;
+        }
+        auto& shard = shards[shardIndex];
+        std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+        for (const auto* orderId : cancelsByShard[shardIndex]) {
+            shard.book.cancelOrder(*orderId);
+        }
+    }
+}
+
+void ShardedOrderCache::cancelOrdersForUser(const std::string& user) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrdersForUser);
+    // A user's orders may sit in any shard; visit them one lock at a time
+    forEachShard([&](std::size_t shardIndex) {
+        std::vector<std::string> cancelledIds;
+        {
+            auto& shard = shards[shardIndex];
+            std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+            shard.book.cancelOrdersForUser(user, &cancelledIds);
+        }
+        dropRoutes(static_cast<std::uint32_t>(shardIndex), cancelledIds);
+    });
+}
+
+void ShardedOrderCache::cancelOrdersForSecIdWithMinimumQty(const std::string& securityId, unsigned int minQty) {
+    OpTimer timer(activeStats(), CacheOp::CancelOrdersForSecIdWithMinimumQty);
+    std::uint32_t shardIndex = shardFor(securityId);
+    std::vector<std::string> cancelledIds;
+    {
+        auto& shard = shards[shardIndex];
+        std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+        timer.locked();
+        shard.book.cancelOrdersForSecIdWithMinimumQty(securityId, minQty, &cancelledIds);
+    }
+    dropRoutes(shardIndex, cancelledIds);
+}
+
+unsigned int ShardedOrderCache::getMatchingSizeForSecurity(const std::string& securityId) {
+    OpTimer timer(activeStats(), CacheOp::GetMatchingSizeForSecurity);
+    auto& shard = shards[shardFor(securityId)];
+    std::shared_lock<FairSharedMutex> shardLock(shard.mutex);
+    timer.locked();
+    return shard.book.getMatchingSizeForSecurity(securityId);
+}
+
+std::vector<SecurityMatch> ShardedOrderCache::getMatchingSizeForAllSecurities() const {
+    OpTimer timer(activeStats(), CacheOp::GetMatchingSizeForAllSecurities);
+    // A security lives in exactly one shard, so the per-shard lists only need merging
+    std::vector<std::vector<SecurityMatch>> perShard(shards.size());
+    forEachShard([&](std::size_t shardIndex) {
+        const auto& shard = shards[shardIndex];
+        std::shared_lock<FairSharedMutex> shardLock(shard.mutex);
+        perShard[shardIndex] = shard.book.getMatchingSizeForAllSecurities();
+    });
+    std::vector<SecurityMatch> matches;
+    for (auto& shardMatches : perShard) {
+        matches.insert(matches.end(), std::make_move_iterator(shardMatches.begin()),
+                       std::make_move_iterator(shardMatches.end()));
+    }
+    std::sort(matches.begin(), matches.end(), [](const SecurityMatch& a, const SecurityMatch& b) {
+        return a.securityId < b.securityId;
+    });
+    return matches;
+}
+
+QtyTotals ShardedOrderCache::getQtyTotalsForSecIdWithMinimumQty(const std::string& securityId,
+                                                                unsigned int minQty) const {
+    const auto& shard = shards[shardFor(securityId)];
+    std::shared_lock<FairSharedMutex> shardLock(shard.mutex);
+    return shard.book.getQtyTotalsForSecIdWithMinimumQty(securityId, minQty);
+}
+
+std::vector<Order> ShardedOrderCache::getAllOrders() const {
+    OpTimer timer(activeStats(), CacheOp::GetAllOrders);
+    std::vector<Order> allOrders;
+    {
+        // The copy reflects a single point in time across all shards
+        auto shardLocks = lockAllShards();
+        timer.locked();
+        for (const auto& shard : shards) {
+            shard.book.appendOrders(allOrders);
+        }
+    }
+    std::sort(allOrders.begin(), allOrders.end(), [](const Order& a, const Order& b) {
+        return a.orderId() < b.orderId();
+    });
+    return allOrders;
+}
+
+void ShardedOrderCache::setStatsEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    if (enabled && !stats) {
+        stats = std::make_unique<CacheStats>();
+    }
+    statsEnabled.store(enabled, std::memory_order_release);
+}
+
+CacheStatsSnapshot ShardedOrderCache::statsSnapshot() const {
+    CacheStatsSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        if (stats) {
+            snapshot.operations = stats->operations();
+        }
+    }
+    for (const auto& shard : shards) {
+        std::shared_lock<FairSharedMutex> shardLock(shard.mutex);
+        snapshot.book.add(shard.book.stats());
+    }
+    return snapshot;
+}
+
+std::vector<std::shared_lock<FairSharedMutex>> ShardedOrderCache::lockAllShards() const {
+    // Lock every shard in index order. Writers hold at most one shard lock at once,
+    // so this cannot deadlock with them.
+    std::vector<std::shared_lock<FairSharedMutex>> shardLocks;
+    shardLocks.reserve(shards.size());
+    for (const auto& shard : shards) {
+        shardLocks.emplace_back(shard.mutex);
+    }
+    return shardLocks;
+}
+
+std::uint32_t ShardedOrderCache::shardFor(const std::string& securityId) const {
+    return static_cast<std::uint32_t>(std::hash<std::string>{}(securityId) % shards.size());
+}
+
+ShardedOrderCache::RouteStripe& ShardedOrderCache::routeFor(const std::string& orderId) {
+    return routes[stripeFor(orderId)];
+}
+
+std::size_t ShardedOrderCache::stripeFor(const std::string& orderId) const {
+    return std::hash<std::string>{}(orderId) % routes.size();
+}
+
+std::vector<std::unique_lock<std::mutex>> ShardedOrderCache::lockStripes(const std::vector<std::string>& orderIds) {
+    std::vector<std::size_t> stripes;
+    stripes.reserve(orderIds.size());
+    for (const auto& orderId : orderIds) {
+        stripes.push_back(stripeFor(orderId));
+    }
+    std::sort(stripes.begin(), stripes.end());
+    stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+
+    // Ascending order keeps concurrent batches from deadlocking each other
+    std::vector<std::unique_lock<std::mutex>> routeLocks;
+    routeLocks.reserve(stripes.size());
+    for (std::size_t stripe : stripes) {
+        routeLocks.emplace_back(routes[stripe].mutex);
+    }
+    return routeLocks;
+}
+
+void ShardedOrderCache::dropRoutes(std::uint32_t shardIndex, const std::vector<std::string>& cancelledIds) {
+    if (cancelledIds.empty()) {
+        return;
+    }
+
+    // Group the IDs by route stripe so each stripe and the shard are locked once per group
+    std::vector<std::pair<std::size_t, const std::string*>> byStripe;
+    byStripe.reserve(cancelledIds.size());
+    for (const auto& orderId : cancelledIds) {
+        byStripe.emplace_back(stripeFor(orderId), &orderId);
+    }
+    std::sort(byStripe.begin(), byStripe.end());
+
+    auto& shard = shards[shardIndex];
+    for (auto groupBegin = byStripe.begin(); groupBegin != byStripe.end();) {
+        auto groupEnd = std::find_if(groupBegin, byStripe.end(), [&](const auto& entry) {
+            return entry.first != groupBegin->first;
+        });
+
+        auto& route = routes[groupBegin->first];
+        std::lock_guard<std::mutex> routeLock(route.mutex);
+        std::lock_guard<FairSharedMutex> shardLock(shard.mutex);
+        for (auto entry = groupBegin; entry != groupEnd; ++entry) {
+            const auto& orderId = *entry->second;
+            auto routeIter = route.shardOf.find(orderId);
+            // Keep the route if the ID was meanwhile re-added, to this or another shard
+            if (routeIter != route.shardOf.end() && routeIter->second == shardIndex && !shard.book.contains(orderId)) {
+                route.shardOf.erase(routeIter);
+            }
+        }
+        groupBegin = groupEnd;
+    }
+}
@@ -0,0 +1,110 @@
+#include "../include/WorkStealingPool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+    : queues(std::max<std::size_t>(threads, 1)) {
+    for (std::size_t home = 1; home < queues.size(); ++home) {
+        workers.emplace_back([this, home] { work(home); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::run(std::size_t count, const std::function<void(std::size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    Batch batch;
+    batch.task = &task;
+    batch.pending.store(count, std::memory_order_relaxed);
+
+    // Contiguous blocks keep neighbouring indexes, which tend to share data, on one thread
+    std::size_t blockSize = (count + queues.size() - 1) / queues.size();
+    for (std::size_t home = 0; home < queues.size(); ++home) {
+        std::size_t begin = home * blockSize;
+        std::size_t end = std::min(count, begin + blockSize);
+        if (begin >= end) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(queues[home].mutex);
+        for (std::size_t index = begin; index < end; ++index) {
+            queues[home].jobs.push_back({&batch, index});
+        }
+    }
+    queued.fetch_add(count, std::memory_order_release);
+    {
+        // Taking the lock orders the notification after a worker's check for work
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+
+    // Work along until this batch is done; jobs of other batches help them finish too
+    while (batch.pending.load(std::memory_order_acquire) > 0) {
+        if (!runOne(0)) {
+            std::this_thread::yield();
+        }
+    }
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+// Helper function to take one job, own queue first, and run it
+bool WorkStealingPool::runOne(std::size_t home) {
+    Job job{nullptr, 0};
+    for (std::size_t offset = 0; offset < queues.size() && !job.batch; ++offset) {
+        Queue& queue = queues[(home + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            continue;
+        }
+        // The owner works from the back, thieves from the front, so they rarely want the same job
+        if (offset == 0) {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+        } else {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+    }
+    if (!job.batch) {
+        return false;
+    }
+    queued.fetch_sub(1, std::memory_order_relaxed);
+
+    Batch& batch = *job.batch;
+    try {
+        (*batch.task)(job.index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(batch.errorMutex);
+        if (!batch.error) {
+            batch.error = std::current_exception();
+        }
+    }
+    // The batch lives on its caller's stack; it must not be touched after the last decrement
+    batch.pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+// Helper function run by each worker thread
+void WorkStealingPool::work(std::size_t home) {
+    for (;;) {
+        if (runOne(home)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,126 @@
+// tests/AsyncOrderCacheTest.cpp
+
+#include "../include/AsyncOrderCache.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+
+TEST(AsyncOrderCacheTest, QueriesSeeEarlierSubmissions) {
+    AsyncOrderCache cache;
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrder(Order("order2", "sec2", "Sell", 200, "user1", "companyA"));
+    cache.addOrder(Order("order3", "sec3", "Buy", 150, "user2", "companyB"));
+    cache.addOrder(Order("order4", "sec3", "Sell", 50, "user3", "companyC"));
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 4);
+    EXPECT_EQ(allOrders[0].orderId(), "order1");
+    EXPECT_EQ(allOrders[3].orderId(), "order4");
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec3"), 50);
+    EXPECT_EQ(cache.getQtyTotalsForSecIdWithMinimumQty("sec3", 100).orders, 1u);
+
+    cache.cancelOrder("order3");
+    cache.cancelOrdersForUser("user1");
+    allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 1);
+    EXPECT_EQ(allOrders[0].orderId(), "order4");
+
+    cache.cancelOrdersForSecIdWithMinimumQty("sec3", 50);
+    EXPECT_TRUE(cache.getAllOrders().empty());
+}
+
+TEST(AsyncOrderCacheTest, BatchesApplyInSubmissionOrder) {
+    AsyncOrderCache cache;
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrders({Order("order2", "sec1", "Sell", 80, "user2", "companyB"),
+                     Order("order1", "sec1", "Buy", 50, "user1", "companyA")});
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 50);
+
+    cache.cancelOrders({"order1", "unknown"});
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 1);
+    EXPECT_EQ(allOrders[0].orderId(), "order2");
+}
+
+TEST(AsyncOrderCacheTest, FlushWaitsForEveryProducer) {
+    AsyncOrderCache cache;
+    cache.reserve(40000);
+    constexpr int producers = 4;
+    constexpr int ordersPerProducer = 10000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < producers; ++t) {
+        threads.emplace_back([&cache, t] {
+            std::string prefix = "T" + std::to_string(t) + "-";
+            for (int i = 0; i < ordersPerProducer; ++i) {
+                cache.addOrder(Order(prefix + std::to_string(i), "sec" + std::to_string(i % 7), i % 2 ? "Buy" : "Sell",
+                                     10, "user" + std::to_string(t), "company" + std::to_string(t)));
+            }
+            // Each producer's own cancels follow its adds in the ring
+            for (int i = 0; i < ordersPerProducer; i += 2) {
+                cache.cancelOrder(prefix + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    cache.flush();
+    EXPECT_EQ(cache.query([](const OrderBook& book) { return book.size(); }),
+              static_cast<std::size_t>(producers * ordersPerProducer / 2));
+}
+
+TEST(AsyncOrderCacheTest, FullRingMakesProducersWait) {
+    AsyncOrderCacheOptions options;
+    options.capacity = 8;
+    AsyncOrderCache cache(options);
+    for (int i = 0; i < 5000; ++i) {
+        cache.addOrder(Order("order" + std::to_string(i), "sec1", "Buy", 10, "user1", "companyA"));
+    }
+    // Nothing is dropped, however often the producer had to wait
+    EXPECT_EQ(cache.getAllOrders().size(), 5000u);
+}
+
+TEST(AsyncOrderCacheTest, QueryErrorsReachTheCaller) {
+    AsyncOrderCache cache;
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    EXPECT_THROW(cache.query([](const OrderBook&) -> int { throw std::runtime_error("query failed"); }),
+                 std::runtime_error);
+
+    // The applier keeps going
+    cache.addOrder(Order("order2", "sec1", "Sell", 100, "user2", "companyB"));
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 100);
+}
+
+TEST(AsyncOrderCacheTest, StatsTimeOperationsAndMeasureIndexes) {
+    AsyncOrderCache cache;
+    cache.setStatsEnabled(true);
+    for (int i = 1; i <= 10; ++i) {
+        cache.addOrder(Order("order" + std::to_string(i), "sec" + std::to_string(i % 2), i % 2 ? "Buy" : "Sell",
+                             100, "user" + std::to_string(i % 3), "company" + std::to_string(i % 4)));
+    }
+    cache.cancelOrders({"order1", "order2"});
+    cache.getMatchingSizeForSecurity("sec1");
+
+    auto snapshot = cache.statsSnapshot();
+    ASSERT_EQ(snapshot.operations.size(), 3);
+    EXPECT_EQ(snapshot.operations[0].name, "addOrder");
+    EXPECT_EQ(snapshot.operations[0].latency.count, 10);
+    EXPECT_EQ(snapshot.operations[0].lockWait.count, 10);
+    EXPECT_EQ(snapshot.operations[1].name, "cancelOrders");
+    EXPECT_EQ(snapshot.operations[1].latency.count, 1);
+    EXPECT_EQ(snapshot.operations[2].name, "getMatchingSizeForSecurity");
+    EXPECT_EQ(snapshot.operations[2].lockWait.count, 1);
+
+    // The book is measured after everything submitted before the snapshot
+    EXPECT_EQ(snapshot.book.orders, 8);
+    EXPECT_EQ(snapshot.book.securities, 2);
+    ASSERT_FALSE(snapshot.book.tables.empty());
+    EXPECT_EQ(snapshot.book.tables[0].entries, 8);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
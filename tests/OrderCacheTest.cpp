@@ -2,6 +2,14 @@
 
 #include "../include/OrderCache.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <set>
+#include <thread>
 
 TEST(OrderCacheTest, AddOrder) {
     OrderCache cache;
@@ -166,6 +174,578 @@ TEST(OrderCacheTest, Example2Test) {
     EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId3"), 0);    // Should be 0
 }
 
+TEST(OrderCacheTest, GetAllOrdersRestoresAllFields) {
+    OrderCache cache;
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrder(Order("order2", "sec1", "Sell", 200, "user2", "companyA"));
+    cache.addOrder(Order("order1", "sec2", "Sell", 300, "user2", "companyB")); // replaces order1
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 2);
+    EXPECT_EQ(allOrders[0].orderId(), "order1");
+    EXPECT_EQ(allOrders[0].securityId(), "sec2");
+    EXPECT_EQ(allOrders[0].side(), "Sell");
+    EXPECT_EQ(allOrders[0].qty(), 300);
+    EXPECT_EQ(allOrders[0].user(), "user2");
+    EXPECT_EQ(allOrders[0].company(), "companyB");
+    EXPECT_EQ(allOrders[1].orderId(), "order2");
+    EXPECT_EQ(allOrders[1].company(), "companyA");
+
+    cache.cancelOrdersForUser("user2");
+    EXPECT_TRUE(cache.getAllOrders().empty());
+}
+
+TEST(OrderCacheTest, CancelKeepsUserAndSecurityIndexesConsistent) {
+    OrderCache cache;
+    for (int i = 0; i < 10; ++i) {
+        std::string user = (i % 2 == 0) ? "userEven" : "userOdd";
+        std::string sec = (i < 5) ? "sec1" : "sec2";
+        cache.addOrder(Order("order" + std::to_string(i), sec, "Buy", 100 + i, user, "companyA"));
+    }
+
+    // Unlink from the head, the middle and the tail of the lists
+    cache.cancelOrder("order9");
+    cache.cancelOrder("order4");
+    cache.cancelOrder("order0");
+
+    cache.cancelOrdersForUser("userOdd");
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 3);
+    EXPECT_EQ(allOrders[0].orderId(), "order2");
+    EXPECT_EQ(allOrders[1].orderId(), "order6");
+    EXPECT_EQ(allOrders[2].orderId(), "order8");
+
+    cache.cancelOrdersForSecIdWithMinimumQty("sec2", 0);
+    allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 1);
+    EXPECT_EQ(allOrders[0].orderId(), "order2");
+
+    cache.cancelOrdersForUser("userEven");
+    EXPECT_TRUE(cache.getAllOrders().empty());
+}
+
+TEST(OrderCacheTest, ZeroQtyOrderOutlivesItsCompanysTotals) {
+    OrderCache cache;
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrder(Order("order2", "sec1", "Buy", 0, "user1", "companyA"));
+    cache.addOrder(Order("order3", "sec1", "Sell", 60, "user2", "companyB"));
+
+    // companyA's totals drop to zero while its qty-0 order still rests
+    cache.cancelOrder("order1");
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 0);
+    cache.cancelOrder("order2");
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 1);
+    EXPECT_EQ(allOrders[0].orderId(), "order3");
+    cache.addOrder(Order("order4", "sec1", "Buy", 40, "user1", "companyA"));
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 40);
+}
+
+TEST(OrderCacheTest, GetMatchingSizeForSecurity_DoesNotModifyCache) {
+    OrderCache cache;
+    cache.addOrder(Order("OrdId1", "SecId1", "Buy", 300, "User1", "Company1"));
+    cache.addOrder(Order("OrdId2", "SecId1", "Sell", 200, "User2", "Company2"));
+    cache.addOrder(Order("OrdId3", "SecId1", "Sell", 400, "User3", "Company1"));
+    cache.addOrder(Order("OrdId4", "SecId1", "Buy", 100, "User4", "Company3"));
+
+    // Company1's 300 buy can only fill 200 against Company2, Company3's 100 buy fills fully
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId1"), 300);
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId1"), 300);
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 4);
+    EXPECT_EQ(allOrders[0].qty(), 300);
+    EXPECT_EQ(allOrders[1].qty(), 200);
+    EXPECT_EQ(allOrders[2].qty(), 400);
+    EXPECT_EQ(allOrders[3].qty(), 100);
+
+    // Totals follow cancels
+    cache.cancelOrder("OrdId3");
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId1"), 200);
+    cache.cancelOrdersForUser("User2");
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId1"), 0);
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("Unknown"), 0);
+}
+
+// Adds 'count' orders to the cache and returns the median latency of a single addOrder call.
+static std::chrono::nanoseconds medianAddLatency(OrderCache& cache, const std::string& prefix, int count) {
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Order order(prefix + std::to_string(i), "sec" + std::to_string(i % 16), i % 2 ? "Buy" : "Sell", 100,
+                    "user" + std::to_string(i % 64), "company" + std::to_string(i % 8));
+        auto start = std::chrono::steady_clock::now();
+        cache.addOrder(order);
+        latencies.push_back(std::chrono::steady_clock::now() - start);
+    }
+    std::nth_element(latencies.begin(), latencies.begin() + count / 2, latencies.end());
+    return latencies[count / 2];
+}
+
+TEST(OrderCacheTest, ReadersDoNotStallWriters) {
+    OrderCache cache;
+    constexpr int ordersPerRun = 20000;
+    auto quietLatency = medianAddLatency(cache, "quiet", ordersPerRun);
+
+    // Hammer the cache with queries while the writer runs again
+    std::atomic<bool> stop{false};
+    std::atomic<bool> snapshotsConsistent{true};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            std::size_t lastSize = 0;
+            while (!stop.load()) {
+                for (int sec = 0; sec < 16; ++sec) {
+                    cache.getMatchingSizeForSecurity("sec" + std::to_string(sec));
+                }
+                auto snapshot = cache.getAllOrders();
+                // The writer only adds, so snapshots never shrink and are always fully sorted
+                if (snapshot.size() < lastSize ||
+                    !std::is_sorted(snapshot.begin(), snapshot.end(), [](const Order& a, const Order& b) {
+                        return a.orderId() < b.orderId();
+                    })) {
+                    snapshotsConsistent = false;
+                }
+                lastSize = snapshot.size();
+            }
+        });
+    }
+    auto contendedLatency = medianAddLatency(cache, "busy", ordersPerRun);
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_TRUE(snapshotsConsistent);
+    EXPECT_EQ(cache.getAllOrders().size(), 2 * ordersPerRun);
+    RecordProperty("quietMedianAddNs", static_cast<int>(quietLatency.count()));
+    RecordProperty("contendedMedianAddNs", static_cast<int>(contendedLatency.count()));
+    // Readers hold the lock only while copying, so the typical write must not degrade with them
+    EXPECT_LT(contendedLatency, std::max(quietLatency * 10, std::chrono::nanoseconds(50000)))
+        << "quiet median " << quietLatency.count() << "ns, contended median " << contendedLatency.count() << "ns";
+}
+
+// Upstream resource that counts the allocations the cache asks for.
+class CountingResource : public std::pmr::memory_resource {
+    public:
+        std::size_t allocations = 0;
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+TEST(OrderCacheTest, ReservedCacheChurnsWithoutUpstreamAllocations) {
+    CountingResource upstream;
+    OrderCache cache(&upstream);
+    constexpr int peakOrders = 1000;
+    cache.reserve(peakOrders);
+    EXPECT_GE(cache.capacity(), peakOrders);
+
+    // Warm up the symbols so only per-order storage is exercised below
+    cache.addOrder(Order("warmup", "sec1", "Buy", 1, "user1", "companyA"));
+    cache.addOrder(Order("warmup", "sec1", "Sell", 1, "user1", "companyB"));
+    cache.cancelOrder("warmup");
+    std::size_t allocationsAfterReserve = upstream.allocations;
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < peakOrders; ++i) {
+            // Long IDs defeat the small string optimization
+            cache.addOrder(Order("a-rather-long-order-identifier-" + std::to_string(i), "sec1",
+                                 i % 2 ? "Buy" : "Sell", 100, "user1", i % 2 ? "companyA" : "companyB"));
+        }
+        EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 50000);
+        cache.cancelOrdersForUser("user1");
+    }
+
+    EXPECT_EQ(upstream.allocations, allocationsAfterReserve);
+    EXPECT_EQ(cache.capacity(), peakOrders);
+}
+
+TEST(OrderCacheTest, AddAndCancelOrdersInBatches) {
+    OrderCache cache;
+    std::vector<Order> batch;
+    batch.emplace_back("order1", "sec1", "Buy", 100, "user1", "companyA");
+    batch.emplace_back("order2", "sec1", "Sell", 200, "user2", "companyB");
+    batch.emplace_back("order3", "sec2", "Sell", 300, "user2", "companyB");
+    batch.emplace_back("order1", "sec1", "Buy", 150, "user1", "companyA"); // later order wins
+    cache.addOrders(std::move(batch));
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 3);
+    EXPECT_EQ(allOrders[0].qty(), 150);
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 150);
+
+    cache.cancelOrders({"order1", "order3", "unknown"});
+    allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 1);
+    EXPECT_EQ(allOrders[0].orderId(), "order2");
+}
+
+TEST(OrderCacheTest, VisitorsStreamOrdersWithoutCopies) {
+    OrderCache cache;
+    cache.addOrder(Order("order3", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrder(Order("order1", "sec2", "Sell", 200, "user2", "companyB"));
+    cache.addOrder(Order("order2", "sec1", "Sell", 300, "user2", "companyB"));
+
+    unsigned int totalQty = 0;
+    cache.visitOrders([&totalQty](const OrderView& order) { totalQty += order.qty; });
+    EXPECT_EQ(totalQty, 600);
+
+    std::vector<std::string> ids;
+    cache.visitOrdersForSecurity("sec1", [&ids](const OrderView& order) { ids.emplace_back(order.orderId); });
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(ids, (std::vector<std::string>{"order2", "order3"}));
+
+    ids.clear();
+    cache.visitOrdersForUser("user2", [&ids](const OrderView& order) {
+        EXPECT_EQ(order.company, "companyB");
+        ids.emplace_back(order.orderId);
+    });
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(ids, (std::vector<std::string>{"order1", "order2"}));
+
+    // Sorted by order ID, with and without the incrementally maintained view
+    for (bool orderedView : {false, true}) {
+        cache.setOrderedViewEnabled(orderedView);
+        ids.clear();
+        cache.visitOrdersById([&ids](const OrderView& order) { ids.emplace_back(order.orderId); });
+        EXPECT_EQ(ids, (std::vector<std::string>{"order1", "order2", "order3"}));
+    }
+
+    // The ordered view follows adds and cancels
+    cache.addOrder(Order("order0", "sec3", "Buy", 50, "user3", "companyC"));
+    cache.cancelOrder("order2");
+    cache.cancelOrdersForUser("user1");
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 2);
+    EXPECT_EQ(allOrders[0].orderId(), "order0");
+    EXPECT_EQ(allOrders[0].securityId(), "sec3");
+    EXPECT_EQ(allOrders[1].orderId(), "order1");
+}
+
+TEST(OrderCacheTest, QtyIndexCountsAndCancelsOnlyQualifyingOrders) {
+    OrderCache cache;
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrder(Order("order2", "sec1", "Sell", 500, "user2", "companyB"));
+    cache.addOrder(Order("order3", "sec1", "Buy", 500, "user3", "companyC"));
+    cache.addOrder(Order("order4", "sec1", "Sell", 900, "user1", "companyA"));
+    cache.addOrder(Order("order5", "sec2", "Buy", 1000, "user2", "companyB"));
+
+    auto totals = cache.getQtyTotalsForSecIdWithMinimumQty("sec1", 500);
+    EXPECT_EQ(totals.orders, 3);
+    EXPECT_EQ(totals.qty, 1900);
+    EXPECT_EQ(cache.getQtyTotalsForSecIdWithMinimumQty("sec1", 901).orders, 0);
+    EXPECT_EQ(cache.getQtyTotalsForSecIdWithMinimumQty("unknown", 0).orders, 0);
+
+    // The index follows cancels and re-adds with a new qty
+    cache.cancelOrder("order2");
+    cache.addOrder(Order("order1", "sec1", "Buy", 700, "user1", "companyA"));
+    totals = cache.getQtyTotalsForSecIdWithMinimumQty("sec1", 0);
+    EXPECT_EQ(totals.orders, 3);
+    EXPECT_EQ(totals.qty, 2100);
+
+    cache.cancelOrdersForUser("user1");
+    totals = cache.getQtyTotalsForSecIdWithMinimumQty("sec1", 0);
+    EXPECT_EQ(totals.orders, 1);
+    EXPECT_EQ(totals.qty, 500);
+
+    cache.addOrder(Order("order6", "sec1", "Sell", 499, "user4", "companyD"));
+    cache.addOrder(Order("order7", "sec1", "Sell", 800, "user4", "companyD"));
+    cache.cancelOrdersForSecIdWithMinimumQty("sec1", 500);
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 2);
+    EXPECT_EQ(allOrders[0].orderId(), "order5");
+    EXPECT_EQ(allOrders[1].orderId(), "order6");
+    EXPECT_EQ(cache.getQtyTotalsForSecIdWithMinimumQty("sec1", 0).qty, 499);
+}
+
+TEST(OrderCacheTest, SecurityScanFollowsCancelsInAnyOrder) {
+    OrderCache cache;
+    std::set<std::string> expected;
+    for (int i = 0; i < 50; ++i) {
+        std::string orderId = "order" + std::to_string(i);
+        cache.addOrder(Order(orderId, "sec1", i % 3 ? "Buy" : "Sell", 10 + i, "user" + std::to_string(i % 4),
+                             "company" + std::to_string(i % 5)));
+        expected.insert(orderId);
+    }
+    // Remove rows from the middle, the front and the back of the security's columns
+    for (int i : {25, 0, 49, 10, 11, 48, 1}) {
+        cache.cancelOrder("order" + std::to_string(i));
+        expected.erase("order" + std::to_string(i));
+    }
+    cache.cancelOrdersForUser("user2");
+    cache.cancelOrdersForSecIdWithMinimumQty("sec1", 50);
+    for (int i = 0; i < 50; ++i) {
+        if (i % 4 == 2 || 10 + i >= 50) {
+            expected.erase("order" + std::to_string(i));
+        }
+    }
+    // A side other than Buy/Sell is kept but never matches
+    unsigned int matching = cache.getMatchingSizeForSecurity("sec1");
+    cache.addOrder(Order("order50", "sec1", "Short", 1000, "user9", "company9"));
+    expected.insert("order50");
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), matching);
+
+    std::set<std::string> scanned;
+    cache.visitOrdersForSecurity("sec1", [&scanned](const OrderView& order) {
+        EXPECT_EQ(order.securityId, "sec1");
+        EXPECT_TRUE(scanned.emplace(order.orderId).second);
+    });
+    EXPECT_EQ(scanned, expected);
+}
+
+#if ORDERCACHE_EVENT_LOG
+TEST(OrderCacheTest, EventLogRecordsMutationsAndQueries) {
+    std::string path = (std::filesystem::temp_directory_path() / "OrderCacheTest-events.log").string();
+    {
+        OrderCache cache;
+        ASSERT_TRUE(cache.enableEventLog(path));
+        cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+        cache.addOrder(Order("order2", "sec1", "Sell", 200, "user2", "companyB"));
+        EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 100);
+        cache.cancelOrder("order1");
+        cache.cancelOrdersForUser("user2");
+        cache.cancelOrdersForSecIdWithMinimumQty("sec1", 50);
+        cache.flushEventLog();
+
+        std::ifstream in(path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(in, line);) {
+            // Drop the timestamp
+            lines.push_back(line.substr(line.find(',') + 1));
+        }
+        EXPECT_EQ(lines, (std::vector<std::string>{
+            "add,order1,sec1,Buy,100,0",
+            "add,order2,sec1,Sell,200,0",
+            "match,,sec1,,0,100",
+            "cancel,order1,,,0,0",
+            "cancelForUser,user2,,,0,1",
+            "cancelForSecIdWithMinimumQty,,sec1,,50,0",
+        }));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(OrderCacheTest, EventLogKeepsEventsOfConcurrentReaders) {
+    std::string path = (std::filesystem::temp_directory_path() / "OrderCacheTest-concurrent.log").string();
+    constexpr int threadCount = 4;
+    constexpr int queriesPerThread = 2000;
+    {
+        OrderCache cache;
+        EventLogOptions options;
+        options.format = EventLogFormat::Binary;
+        options.capacity = 1 << 10;
+        ASSERT_TRUE(cache.enableEventLog(path, options));
+        cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+
+        // Matching queries share the lock, so these threads record into the ring at once
+        std::vector<std::thread> readers;
+        for (int t = 0; t < threadCount; ++t) {
+            readers.emplace_back([&cache] {
+                for (int i = 0; i < queriesPerThread; ++i) {
+                    cache.getMatchingSizeForSecurity("sec1");
+                }
+            });
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+    }
+    // Every event is either in the file or was dropped on a full ring; none is torn
+    std::ifstream in(path, std::ios::binary);
+    char magic[8];
+    in.read(magic, sizeof(magic));
+    std::size_t adds = 0, matches = 0;
+    for (Event event; in.read(reinterpret_cast<char*>(&event), sizeof(event));) {
+        if (event.type == EventType::Add) {
+            ++adds;
+            EXPECT_STREQ(event.key, "order1");
+        } else {
+            ASSERT_EQ(event.type, EventType::Match);
+            EXPECT_STREQ(event.securityId, "sec1");
+            ++matches;
+        }
+    }
+    EXPECT_EQ(adds, 1);
+    EXPECT_GT(matches, 0);
+    EXPECT_LE(matches, threadCount * queriesPerThread);
+    std::filesystem::remove(path);
+}
+#endif
+
+TEST(OrderCacheTest, LatencyHistogramPercentiles) {
+    LatencyHistogram histogram;
+    for (std::uint64_t ns = 1; ns <= 1000; ++ns) {
+        histogram.record(ns * 1000);
+    }
+    LatencySummary summary = histogram.summary();
+    EXPECT_EQ(summary.count, 1000);
+    EXPECT_EQ(summary.minNs, 1000);
+    EXPECT_EQ(summary.maxNs, 1000000);
+    EXPECT_DOUBLE_EQ(summary.meanNs(), 500500.0);
+    // Buckets are ~3% wide, and reported by their upper bound
+    EXPECT_GE(summary.p50Ns, 500000);
+    EXPECT_LE(summary.p50Ns, 500000 * 103 / 100);
+    EXPECT_GE(summary.p99Ns, 990000);
+    EXPECT_LE(summary.p99Ns, 1000000);
+    EXPECT_EQ(LatencyHistogram().summary().count, 0);
+}
+
+TEST(OrderCacheTest, StatsTimeOperationsAndMeasureIndexes) {
+    OrderCache cache;
+    cache.addOrder(Order("order0", "sec1", "Buy", 100, "user1", "companyA"));  // not timed
+    cache.setStatsEnabled(true);
+    for (int i = 1; i <= 10; ++i) {
+        cache.addOrder(Order("order" + std::to_string(i), "sec" + std::to_string(i % 2), i % 2 ? "Buy" : "Sell",
+                             100, "user" + std::to_string(i % 3), "company" + std::to_string(i % 4)));
+    }
+    cache.cancelOrder("order1");
+    cache.getMatchingSizeForSecurity("sec1");
+    cache.getMatchingSizeForSecurity("sec0");
+
+    auto snapshot = cache.statsSnapshot();
+    ASSERT_EQ(snapshot.operations.size(), 3);
+    EXPECT_EQ(snapshot.operations[0].name, "addOrder");
+    EXPECT_EQ(snapshot.operations[0].latency.count, 10);
+    EXPECT_EQ(snapshot.operations[0].lockWait.count, 10);
+    EXPECT_LE(snapshot.operations[0].lockWait.maxNs, snapshot.operations[0].latency.maxNs);
+    EXPECT_EQ(snapshot.operations[1].name, "cancelOrder");
+    EXPECT_EQ(snapshot.operations[2].name, "getMatchingSizeForSecurity");
+    EXPECT_EQ(snapshot.operations[2].latency.count, 2);
+
+    EXPECT_EQ(snapshot.book.orders, 10);
+    EXPECT_EQ(snapshot.book.users, 3);
+    EXPECT_EQ(snapshot.book.securities, 2);
+    ASSERT_FALSE(snapshot.book.tables.empty());
+    EXPECT_EQ(snapshot.book.tables[0].name, "orders");
+    EXPECT_EQ(snapshot.book.tables[0].entries, 10);
+    EXPECT_EQ(snapshot.book.tables[0].usedBuckets + snapshot.book.tables[0].collidedEntries, 10);
+
+    std::string json = snapshot.toJson();
+    EXPECT_NE(json.find("\"addOrder\":{\"latency\":{\"count\":10,"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"orders\":{\"entries\":10,"), std::string::npos) << json;
+    EXPECT_NE(snapshot.toText().find("getMatchingSizeForSecurity"), std::string::npos);
+
+    // Disabled again: nothing more is timed, the histograms are kept
+    cache.setStatsEnabled(false);
+    cache.cancelOrder("order2");
+    EXPECT_EQ(cache.statsSnapshot().operations[1].latency.count, 1);
+}
+
+// Orders of one security in the book's column order, as "orderId:qty".
+static std::vector<std::string> securityLayout(const OrderCache& cache, const std::string& securityId) {
+    std::vector<std::string> layout;
+    cache.visitOrdersForSecurity(securityId, [&layout](const OrderView& order) {
+        layout.push_back(std::string(order.orderId) + ":" + std::to_string(order.qty));
+    });
+    return layout;
+}
+
+TEST(OrderCacheTest, ParallelReportAndBulkCancelMatchSerial) {
+    OrderCache serial;
+    OrderCache parallel;
+    parallel.setParallelism(4);
+    // A market maker quoting both sides in every security, above the parallel cancel threshold
+    for (int i = 0; i < 6000; ++i) {
+        Order order("mm" + std::to_string(i), "sec" + std::to_string(i % 300), i % 2 ? "Buy" : "Sell",
+                    100 + i % 7, "marketMaker", "companyM");
+        serial.addOrder(order);
+        parallel.addOrder(order);
+    }
+    for (int i = 0; i < 3000; ++i) {
+        Order order("o" + std::to_string(i), "sec" + std::to_string(i % 400), i % 3 ? "Sell" : "Buy",
+                    50 + i % 11, "user" + std::to_string(i % 20), "company" + std::to_string(i % 5));
+        serial.addOrder(order);
+        parallel.addOrder(order);
+    }
+
+    auto report = parallel.getMatchingSizeForAllSecurities();
+    ASSERT_EQ(report, serial.getMatchingSizeForAllSecurities());
+    ASSERT_EQ(report.size(), 400);
+    EXPECT_TRUE(std::is_sorted(report.begin(), report.end(), [](const SecurityMatch& a, const SecurityMatch& b) {
+        return a.securityId < b.securityId;
+    }));
+    for (const auto& match : report) {
+        EXPECT_EQ(match.matchingSize, serial.getMatchingSizeForSecurity(match.securityId)) << match.securityId;
+    }
+
+    serial.cancelOrdersForUser("marketMaker");
+    parallel.cancelOrdersForUser("marketMaker");
+    EXPECT_EQ(parallel.getMatchingSizeForAllSecurities(), serial.getMatchingSizeForAllSecurities());
+    EXPECT_EQ(parallel.getAllOrders().size(), 3000);
+    // Not just the same orders: every security's columns end up in the same row order
+    for (int sec = 0; sec < 400; ++sec) {
+        std::string securityId = "sec" + std::to_string(sec);
+        ASSERT_EQ(securityLayout(parallel, securityId), securityLayout(serial, securityId)) << securityId;
+    }
+
+    // The indexes stay usable afterwards
+    parallel.cancelOrdersForSecIdWithMinimumQty("sec1", 0);
+    serial.cancelOrdersForSecIdWithMinimumQty("sec1", 0);
+    parallel.addOrder(Order("mm1", "sec1", "Buy", 10, "marketMaker", "companyM"));
+    serial.addOrder(Order("mm1", "sec1", "Buy", 10, "marketMaker", "companyM"));
+    EXPECT_EQ(parallel.getMatchingSizeForAllSecurities(), serial.getMatchingSizeForAllSecurities());
+}
+
+TEST(OrderCacheTest, BatchAddsMatchOrderByOrderAdds) {
+    OrderCache single;
+    OrderCache batched;
+    std::vector<Order> resting;
+    for (int i = 0; i < 200; ++i) {
+        resting.emplace_back("o" + std::to_string(i), "sec" + std::to_string(i % 13), i % 2 ? "Buy" : "Sell",
+                             10 + i % 9, "user" + std::to_string(i % 7), "company" + std::to_string(i % 4));
+    }
+    for (const auto& order : resting) {
+        single.addOrder(order);
+    }
+    batched.addOrders(resting);
+
+    // Replace resting orders, and orders of the same batch, more than once
+    std::vector<Order> burst;
+    for (int i = 0; i < 300; ++i) {
+        burst.emplace_back("o" + std::to_string(i * 7 % 260), "sec" + std::to_string(i % 17), i % 3 ? "Buy" : "Sell",
+                           i % 11, "user" + std::to_string(i % 9), "company" + std::to_string(i % 5));
+    }
+    for (const auto& order : burst) {
+        single.addOrder(order);
+    }
+    batched.addOrders(burst);
+
+    // Replaced resting orders leave the batch's orders in another row order; the orders are the same
+    auto sortedLayout = [](const OrderCache& cache, const std::string& securityId) {
+        auto layout = securityLayout(cache, securityId);
+        std::sort(layout.begin(), layout.end());
+        return layout;
+    };
+    EXPECT_EQ(batched.getMatchingSizeForAllSecurities(), single.getMatchingSizeForAllSecurities());
+    for (int sec = 0; sec < 17; ++sec) {
+        std::string securityId = "sec" + std::to_string(sec);
+        ASSERT_EQ(sortedLayout(batched, securityId), sortedLayout(single, securityId)) << securityId;
+    }
+    for (int user = 0; user < 9; ++user) {
+        std::vector<std::string> singleIds;
+        std::vector<std::string> batchedIds;
+        single.visitOrdersForUser("user" + std::to_string(user), [&](const OrderView& order) { singleIds.emplace_back(order.orderId); });
+        batched.visitOrdersForUser("user" + std::to_string(user), [&](const OrderView& order) { batchedIds.emplace_back(order.orderId); });
+        EXPECT_EQ(batchedIds, singleIds) << user;
+    }
+
+    // The qty index agrees too
+    single.cancelOrdersForSecIdWithMinimumQty("sec3", 5);
+    batched.cancelOrdersForSecIdWithMinimumQty("sec3", 5);
+    EXPECT_EQ(sortedLayout(batched, "sec3"), sortedLayout(single, "sec3"));
+    EXPECT_EQ(batched.getQtyTotalsForSecIdWithMinimumQty("sec4", 3).qty, single.getQtyTotalsForSecIdWithMinimumQty("sec4", 3).qty);
+    EXPECT_EQ(batched.getAllOrders().size(), single.getAllOrders().size());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,122 @@
+// tests/OrderIdIndexTest.cpp
+
+#include "../include/OrderIdIndex.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    // Keys addressed by handle, the way OrderBook keeps order IDs in its records.
+    struct Keys {
+        std::vector<std::string> ids;
+        std::vector<std::uint64_t> hashes;
+
+        OrderIdIndex::Handle add(const std::string& id, std::uint64_t hash) {
+            ids.push_back(id);
+            hashes.push_back(hash);
+            return static_cast<OrderIdIndex::Handle>(ids.size() - 1);
+        }
+
+        OrderIdIndex::Handle find(const OrderIdIndex& index, const std::string& id, std::uint64_t hash) const {
+            return index.find(hash, [&](OrderIdIndex::Handle handle) { return ids[handle] == id; });
+        }
+    };
+}
+
+TEST(OrderIdIndexTest, MatchesUnorderedMapThroughGrowthAndChurn) {
+    OrderIdIndex index;
+    Keys keys;
+    std::unordered_map<std::string, OrderIdIndex::Handle> reference;
+    std::mt19937 rng(11);
+
+    // No reserve: the index grows many times and is probed in the middle of every migration
+    for (int i = 0; i < 50000; ++i) {
+        std::string id = "OrdId" + std::to_string(rng() % 20000);
+        std::uint64_t hash = OrderIdIndex::hash(id);
+        auto found = reference.find(id);
+        if (rng() % 3 == 0) {
+            if (found != reference.end()) {
+                ASSERT_TRUE(index.erase(hash, found->second));
+                reference.erase(found);
+            }
+            ASSERT_EQ(keys.find(index, id, hash), OrderIdIndex::npos);
+        } else if (found == reference.end()) {
+            OrderIdIndex::Handle handle = keys.add(id, hash);
+            index.insert(hash, handle);
+            reference.emplace(id, handle);
+        }
+        ASSERT_EQ(index.size(), reference.size());
+    }
+
+    for (const auto& [id, handle] : reference) {
+        EXPECT_EQ(keys.find(index, id, OrderIdIndex::hash(id)), handle);
+    }
+    EXPECT_EQ(keys.find(index, "OrdIdMissing", OrderIdIndex::hash("OrdIdMissing")), OrderIdIndex::npos);
+    EXPECT_FALSE(index.erase(OrderIdIndex::hash("OrdIdMissing"), 0));
+}
+
+TEST(OrderIdIndexTest, CollidingHashesStayReachable) {
+    // Every key hashes alike, so each lookup has to probe past full groups and tombstones
+    OrderIdIndex index;
+    Keys keys;
+    const std::uint64_t hash = 42;
+    for (int i = 0; i < 200; ++i) {
+        index.insert(hash, keys.add("OrdId" + std::to_string(i), hash));
+    }
+    for (OrderIdIndex::Handle handle = 0; handle < 200; handle += 2) {
+        ASSERT_TRUE(index.erase(hash, handle));
+    }
+    for (int i = 200; i < 300; ++i) {
+        index.insert(hash, keys.add("OrdId" + std::to_string(i), hash));
+    }
+
+    EXPECT_EQ(index.size(), 200u);
+    for (OrderIdIndex::Handle handle = 0; handle < 300; ++handle) {
+        OrderIdIndex::Handle expected = handle < 200 && handle % 2 == 0 ? OrderIdIndex::npos : handle;
+        EXPECT_EQ(keys.find(index, keys.ids[handle], hash), expected) << keys.ids[handle];
+    }
+}
+
+TEST(OrderIdIndexTest, ForEachVisitsEveryEntryOnceWhileGrowing) {
+    OrderIdIndex index;
+    index.reserve(100);
+    Keys keys;
+    for (int i = 0; i < 5000; ++i) {
+        std::string id = "OrdId" + std::to_string(i);
+        index.insert(OrderIdIndex::hash(id), keys.add(id, OrderIdIndex::hash(id)));
+
+        if (i % 97 == 0) {
+            std::multiset<OrderIdIndex::Handle> visited;
+            index.forEach([&](OrderIdIndex::Handle handle) { visited.insert(handle); });
+            ASSERT_EQ(visited.size(), static_cast<std::size_t>(i + 1));
+            ASSERT_EQ(std::set<OrderIdIndex::Handle>(visited.begin(), visited.end()).size(), visited.size());
+        }
+    }
+    EXPECT_GE(index.capacity(), index.size());
+}
+
+TEST(OrderIdIndexTest, StatsDescribeOccupancy) {
+    OrderIdIndex index;
+    Keys keys;
+    for (int i = 0; i < 1000; ++i) {
+        std::string id = "OrdId" + std::to_string(i);
+        index.insert(OrderIdIndex::hash(id), keys.add(id, OrderIdIndex::hash(id)));
+    }
+
+    HashTableStats stats = index.stats("orders");
+    EXPECT_EQ(stats.name, "orders");
+    EXPECT_EQ(stats.entries, 1000u);
+    EXPECT_GE(stats.buckets, stats.entries);
+    EXPECT_GE(stats.usedBuckets, stats.entries);
+    EXPECT_LE(stats.loadFactor, stats.maxLoadFactor);
+    EXPECT_GE(stats.longestChain, 1u);
+    EXPECT_LT(stats.collidedEntries, stats.entries);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
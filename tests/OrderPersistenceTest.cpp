@@ -0,0 +1,238 @@
+// tests/OrderPersistenceTest.cpp
+
+#include "../include/OrderCache.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+// Fresh, empty persistence directory per test.
+class OrderPersistenceTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+            directory = (fs::temp_directory_path() / (std::string("OrderPersistenceTest-") + info->name())).string();
+            fs::remove_all(directory);
+        }
+
+        void TearDown() override {
+            fs::remove_all(directory);
+        }
+
+        std::vector<fs::path> journalSegments() const {
+            std::vector<fs::path> segments;
+            for (const auto& entry : fs::directory_iterator(directory)) {
+                if (entry.path().extension() == ".log") {
+                    segments.push_back(entry.path());
+                }
+            }
+            std::sort(segments.begin(), segments.end());
+            return segments;
+        }
+
+        std::string directory;
+};
+
+TEST_F(OrderPersistenceTest, JournalRestoresEveryMutation) {
+    {
+        OrderCache cache;
+        cache.enablePersistence(directory);
+        cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+        cache.addOrder(Order("order2", "sec1", "Sell", 200, "user2", "companyB"));
+        cache.addOrder(Order("order3", "sec2", "Sell", 300, "user1", "companyA"));
+        cache.addOrders({Order("order4", "sec2", "Buy", 400, "user3", "companyC"),
+                         Order("order5", "sec3", "Buy", 500, "user2", "companyB"),
+                         Order("order6", "sec3", "Sell", 50, "user3", "companyC")});
+        cache.cancelOrder("order2");
+        cache.cancelOrder("unknown");  // removes nothing, so it is not journaled
+        cache.cancelOrdersForUser("user1");
+        cache.cancelOrdersForSecIdWithMinimumQty("sec3", 100);
+    }
+
+    OrderCache restored;
+    RecoveryStats stats = restored.enablePersistence(directory);
+    EXPECT_EQ(stats.snapshotOrders, 0);
+    EXPECT_EQ(stats.journalRecords, 9);
+    EXPECT_FALSE(stats.truncatedTail);
+
+    auto allOrders = restored.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 2);
+    EXPECT_EQ(allOrders[0].orderId(), "order4");
+    EXPECT_EQ(allOrders[0].securityId(), "sec2");
+    EXPECT_EQ(allOrders[0].side(), "Buy");
+    EXPECT_EQ(allOrders[0].qty(), 400);
+    EXPECT_EQ(allOrders[0].user(), "user3");
+    EXPECT_EQ(allOrders[0].company(), "companyC");
+    EXPECT_EQ(allOrders[1].orderId(), "order6");
+}
+
+TEST_F(OrderPersistenceTest, CheckpointLeavesOnlyTheTailToReplay) {
+    {
+        OrderCache cache;
+        cache.enablePersistence(directory);
+        for (int i = 0; i < 100; ++i) {
+            cache.addOrder(Order("order" + std::to_string(i), "sec" + std::to_string(i % 5),
+                                 i % 2 ? "Sell" : "Buy", 100 + i, "user" + std::to_string(i % 7),
+                                 "company" + std::to_string(i % 3)));
+        }
+        cache.checkpoint();
+        cache.cancelOrder("order0");
+        cache.addOrder(Order("order100", "sec0", "Sell", 1000, "user0", "company1"));
+    }
+    // The segments written before the checkpoint are gone
+    EXPECT_EQ(journalSegments().size(), 1);
+
+    OrderCache restored;
+    RecoveryStats stats = restored.enablePersistence(directory);
+    EXPECT_EQ(stats.snapshotOrders, 100);
+    EXPECT_EQ(stats.journalRecords, 2);
+
+    OrderCache expected;
+    for (int i = 1; i <= 100; ++i) {
+        expected.addOrder(i < 100 ? Order("order" + std::to_string(i), "sec" + std::to_string(i % 5),
+                                          i % 2 ? "Sell" : "Buy", 100 + i, "user" + std::to_string(i % 7),
+                                          "company" + std::to_string(i % 3))
+                                  : Order("order100", "sec0", "Sell", 1000, "user0", "company1"));
+    }
+    auto allOrders = restored.getAllOrders();
+    auto expectedOrders = expected.getAllOrders();
+    ASSERT_EQ(allOrders.size(), expectedOrders.size());
+    for (size_t i = 0; i < allOrders.size(); ++i) {
+        EXPECT_EQ(allOrders[i].orderId(), expectedOrders[i].orderId());
+        EXPECT_EQ(allOrders[i].qty(), expectedOrders[i].qty());
+        EXPECT_EQ(allOrders[i].company(), expectedOrders[i].company());
+    }
+    for (int s = 0; s < 5; ++s) {
+        std::string securityId = "sec" + std::to_string(s);
+        EXPECT_EQ(restored.getMatchingSizeForSecurity(securityId), expected.getMatchingSizeForSecurity(securityId));
+    }
+
+    // A second restart after another checkpoint needs no journal at all
+    restored.checkpoint();
+    OrderCache again;
+    stats = again.enablePersistence(directory);
+    EXPECT_EQ(stats.snapshotOrders, 100);
+    EXPECT_EQ(stats.journalRecords, 0);
+}
+
+TEST_F(OrderPersistenceTest, TornJournalTailIsCutOff) {
+    {
+        OrderCache cache;
+        cache.enablePersistence(directory);
+        cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+        cache.addOrder(Order("order2", "sec1", "Sell", 200, "user2", "companyB"));
+    }
+    auto segments = journalSegments();
+    ASSERT_EQ(segments.size(), 1);
+    // Simulate a crash halfway through writing a third record
+    fs::resize_file(segments[0], fs::file_size(segments[0]) - 5);
+
+    {
+        OrderCache restored;
+        RecoveryStats stats = restored.enablePersistence(directory);
+        EXPECT_EQ(stats.journalRecords, 1);
+        EXPECT_TRUE(stats.truncatedTail);
+        auto allOrders = restored.getAllOrders();
+        ASSERT_EQ(allOrders.size(), 1);
+        EXPECT_EQ(allOrders[0].orderId(), "order1");
+        restored.addOrder(Order("order3", "sec1", "Sell", 300, "user3", "companyC"));
+    }
+
+    // The damaged tail was removed for good, and later records are not lost behind it
+    OrderCache restored;
+    RecoveryStats stats = restored.enablePersistence(directory);
+    EXPECT_FALSE(stats.truncatedTail);
+    EXPECT_EQ(stats.journalRecords, 2);
+    EXPECT_EQ(restored.getMatchingSizeForSecurity("sec1"), 100);
+}
+
+TEST_F(OrderPersistenceTest, CorruptRecordStopsReplay) {
+    {
+        OrderCache cache;
+        cache.enablePersistence(directory, JournalOptions{1});
+        cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+        cache.addOrder(Order("order2", "sec1", "Sell", 200, "user2", "companyB"));
+    }
+    auto segments = journalSegments();
+    ASSERT_EQ(segments.size(), 1);
+    {
+        // Flip the last byte of the second record's body
+        std::fstream file(segments[0], std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('X');
+    }
+
+    OrderCache restored;
+    RecoveryStats stats = restored.enablePersistence(directory);
+    EXPECT_EQ(stats.journalRecords, 1);
+    EXPECT_TRUE(stats.truncatedTail);
+    EXPECT_EQ(restored.getAllOrders().size(), 1);
+}
+
+TEST_F(OrderPersistenceTest, ProcessCrashKeepsUnsyncedRecords) {
+    std::string copy = directory + "-crashed";
+    fs::remove_all(copy);
+    {
+        OrderCache cache;
+        cache.enablePersistence(directory);  // fsyncs only every 1024 records
+        cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+        cache.addOrders({Order("order2", "sec1", "Sell", 200, "user2", "companyB"),
+                         Order("order3", "sec2", "Sell", 300, "user1", "companyA")});
+        cache.cancelOrder("order1");
+        // Copy the files while the cache is alive, as a killed process would leave them
+        fs::copy(directory, copy);
+    }
+
+    OrderCache restored;
+    RecoveryStats stats = restored.enablePersistence(copy);
+    EXPECT_EQ(stats.journalRecords, 4);
+    auto allOrders = restored.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 2);
+    EXPECT_EQ(allOrders[0].orderId(), "order2");
+    EXPECT_EQ(allOrders[1].orderId(), "order3");
+    fs::remove_all(copy);
+}
+
+TEST_F(OrderPersistenceTest, StrayJournalNamesAreSkipped) {
+    {
+        OrderCache cache;
+        cache.enablePersistence(directory);
+        cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    }
+    // Same length and affixes as a segment, but not a segment number
+    std::ofstream(fs::path(directory) / "journal-0000000000000abc.log") << "not a journal";
+    std::ofstream(fs::path(directory) / "journal-+000000000000001.log") << "not a journal";
+    std::ofstream(fs::path(directory) / "journal-backup-copy-0001.log") << "not a journal";
+
+    OrderCache restored;
+    RecoveryStats stats = restored.enablePersistence(directory);
+    EXPECT_EQ(stats.journalRecords, 1);
+    EXPECT_EQ(restored.getAllOrders().size(), 1);
+}
+
+TEST_F(OrderPersistenceTest, JournalIsCheckpointedEveryNRecords) {
+    {
+        OrderCache cache;
+        JournalOptions options;
+        options.checkpointEveryRecords = 3;
+        cache.enablePersistence(directory, options);
+        for (int i = 1; i <= 7; ++i) {
+            cache.addOrder(Order("order" + std::to_string(i), "sec1", "Buy", 100, "user1", "companyA"));
+        }
+        // The checkpoint after the sixth record dropped the older segments
+        EXPECT_TRUE(fs::exists(fs::path(directory) / "snapshot.bin"));
+        EXPECT_EQ(journalSegments().size(), 1);
+    }
+
+    OrderCache restored;
+    RecoveryStats stats = restored.enablePersistence(directory);
+    EXPECT_EQ(stats.snapshotOrders, 6);
+    EXPECT_EQ(stats.journalRecords, 1);
+    EXPECT_EQ(restored.getAllOrders().size(), 7);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,71 @@
+// tests/QtyKernelsTest.cpp
+
+#include "../include/QtyKernels.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    // Every kernel flavour this CPU can run.
+    std::vector<const QtyKernels*> supportedKernels() {
+        std::vector<const QtyKernels*> kernels;
+        for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::SSE4, KernelIsa::AVX2}) {
+            if (const QtyKernels* candidate = QtyKernels::forIsa(isa)) {
+                kernels.push_back(candidate);
+            }
+        }
+        return kernels;
+    }
+}
+
+TEST(QtyKernelsTest, BestIsSupported) {
+    const QtyKernels& best = QtyKernels::best();
+    EXPECT_EQ(QtyKernels::forIsa(best.isa), &best);
+    ASSERT_NE(QtyKernels::forIsa(KernelIsa::Scalar), nullptr);
+}
+
+TEST(QtyKernelsTest, AllFlavoursAgreeWithScalar) {
+    const QtyKernels& scalar = *QtyKernels::forIsa(KernelIsa::Scalar);
+    std::mt19937 rng(7);
+    // Lengths around the vector widths exercise both the vector loop and the scalar tail
+    for (std::size_t rows : {0, 1, 3, 4, 7, 8, 9, 31, 1000, 4099}) {
+        std::vector<std::uint32_t> qty(rows);
+        std::vector<std::uint64_t> buy(rows), sell(rows);
+        for (std::size_t i = 0; i < rows; ++i) {
+            // Include values with the top bit set, which a signed compare would get wrong
+            qty[i] = i % 17 == 0 ? std::numeric_limits<std::uint32_t>::max() - static_cast<std::uint32_t>(i) : rng() % 10000;
+            buy[i] = i % 13 == 0 ? (1ULL << 63) + i : rng();
+            sell[i] = rng();
+        }
+
+        for (const QtyKernels* kernels : supportedKernels()) {
+            SCOPED_TRACE("isa " + std::to_string(static_cast<int>(kernels->isa)) + ", rows " + std::to_string(rows));
+            for (std::uint32_t minQty : {0u, 1u, 5000u, 10000u, std::numeric_limits<std::uint32_t>::max()}) {
+                QtyTotals expected = scalar.totalsAtLeast(qty.data(), rows, minQty);
+                QtyTotals totals = kernels->totalsAtLeast(qty.data(), rows, minQty);
+                EXPECT_EQ(totals.orders, expected.orders);
+                EXPECT_EQ(totals.qty, expected.qty);
+            }
+
+            EXPECT_EQ(kernels->maxSum(buy.data(), sell.data(), rows), scalar.maxSum(buy.data(), sell.data(), rows));
+        }
+    }
+}
+
+TEST(QtyKernelsTest, ScalarResults) {
+    const QtyKernels& scalar = *QtyKernels::forIsa(KernelIsa::Scalar);
+    std::vector<std::uint32_t> qty{100, 200, 300, 400, 500};
+    QtyTotals totals = scalar.totalsAtLeast(qty.data(), qty.size(), 300);
+    EXPECT_EQ(totals.orders, 3);
+    EXPECT_EQ(totals.qty, 1200);
+
+    std::vector<std::uint64_t> buy{10, 0, 5}, sell{0, 20, 14};
+    EXPECT_EQ(scalar.maxSum(buy.data(), sell.data(), buy.size()), 20);
+    EXPECT_EQ(scalar.maxSum(nullptr, nullptr, 0), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,241 @@
+// tests/ShardedOrderCacheTest.cpp
+
+#include "../include/ShardedOrderCache.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+
+TEST(ShardedOrderCacheTest, AddAndCancelAcrossShards) {
+    ShardedOrderCache cache(4);
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrder(Order("order2", "sec2", "Sell", 200, "user1", "companyA"));
+    cache.addOrder(Order("order3", "sec3", "Buy", 150, "user2", "companyB"));
+    cache.addOrder(Order("order4", "sec3", "Sell", 50, "user3", "companyC"));
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 4);
+    EXPECT_EQ(allOrders[0].orderId(), "order1");
+    EXPECT_EQ(allOrders[3].orderId(), "order4");
+
+    cache.cancelOrder("order3");
+    cache.cancelOrdersForUser("user1");
+    allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 1);
+    EXPECT_EQ(allOrders[0].orderId(), "order4");
+
+    cache.cancelOrdersForSecIdWithMinimumQty("sec3", 50);
+    EXPECT_TRUE(cache.getAllOrders().empty());
+}
+
+TEST(ShardedOrderCacheTest, ReAddedOrderMovesToNewSecurity) {
+    ShardedOrderCache cache(8);
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.addOrder(Order("order1", "sec2", "Sell", 300, "user1", "companyA"));
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 1);
+    EXPECT_EQ(allOrders[0].securityId(), "sec2");
+
+    // The route must follow the order to its new shard
+    cache.cancelOrder("order1");
+    EXPECT_TRUE(cache.getAllOrders().empty());
+
+    // Routes of bulk-cancelled orders are dropped, so the ID can be reused
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+    cache.cancelOrdersForUser("user1");
+    cache.addOrder(Order("order1", "sec3", "Buy", 100, "user2", "companyB"));
+    cache.cancelOrder("order1");
+    EXPECT_TRUE(cache.getAllOrders().empty());
+}
+
+TEST(ShardedOrderCacheTest, MatchesLikeSingleCache) {
+    ShardedOrderCache cache(3);
+    cache.addOrder(Order("OrdId1", "SecId3", "Sell", 100, "User1", "Company1"));
+    cache.addOrder(Order("OrdId2", "SecId3", "Sell", 200, "User3", "Company2"));
+    cache.addOrder(Order("OrdId3", "SecId1", "Buy", 300, "User2", "Company1"));
+    cache.addOrder(Order("OrdId4", "SecId3", "Sell", 400, "User5", "Company2"));
+    cache.addOrder(Order("OrdId5", "SecId2", "Sell", 500, "User2", "Company1"));
+    cache.addOrder(Order("OrdId6", "SecId2", "Buy", 600, "User3", "Company2"));
+    cache.addOrder(Order("OrdId7", "SecId2", "Sell", 700, "User1", "Company1"));
+    cache.addOrder(Order("OrdId8", "SecId1", "Sell", 800, "User2", "Company1"));
+    cache.addOrder(Order("OrdId9", "SecId1", "Buy", 900, "User5", "Company2"));
+    cache.addOrder(Order("OrdId10", "SecId1", "Sell", 1000, "User1", "Company1"));
+    cache.addOrder(Order("OrdId11", "SecId2", "Sell", 1100, "User6", "Company2"));
+
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId1"), 900);
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId2"), 600);
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("SecId3"), 0);
+}
+
+TEST(ShardedOrderCacheTest, AddAndCancelOrdersInBatches) {
+    ShardedOrderCache cache(4);
+    cache.addOrder(Order("order1", "sec1", "Buy", 100, "user1", "companyA"));
+
+    std::vector<Order> batch;
+    for (int i = 2; i <= 20; ++i) {
+        batch.emplace_back("order" + std::to_string(i), "sec" + std::to_string(i % 5), "Sell", 10, "user2", "companyB");
+    }
+    batch.emplace_back("order1", "sec4", "Sell", 50, "user1", "companyA");  // moves order1 to another security
+    batch.emplace_back("order2", "sec1", "Sell", 70, "user2", "companyB");  // replaces order2 from this batch
+    cache.addOrders(std::move(batch));
+
+    auto allOrders = cache.getAllOrders();
+    ASSERT_EQ(allOrders.size(), 20);
+    EXPECT_EQ(allOrders[0].orderId(), "order1");
+    EXPECT_EQ(allOrders[0].securityId(), "sec4");
+    EXPECT_EQ(cache.getMatchingSizeForSecurity("sec1"), 0);
+
+    std::vector<std::string> ids;
+    for (int i = 1; i <= 20; i += 2) {
+        ids.push_back("order" + std::to_string(i));
+    }
+    cache.cancelOrders(ids);
+    EXPECT_EQ(cache.getAllOrders().size(), 10);
+
+    // Routes of batch-cancelled orders are gone, so single cancels of them are no-ops
+    cache.cancelOrder("order1");
+    cache.cancelOrdersForUser("user2");
+    EXPECT_TRUE(cache.getAllOrders().empty());
+}
+
+TEST(ShardedOrderCacheTest, VisitorsSpanAllShards) {
+    ShardedOrderCache cache(4);
+    for (int i = 9; i >= 0; --i) {
+        cache.addOrder(Order("order" + std::to_string(i), "sec" + std::to_string(i % 3), "Buy", 10,
+                             i % 2 ? "userOdd" : "userEven", "companyA"));
+    }
+
+    std::vector<std::string> ids;
+    cache.visitOrdersById([&ids](const OrderView& order) { ids.emplace_back(order.orderId); });
+    ASSERT_EQ(ids.size(), 10);
+    EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+
+    int userOrders = 0;
+    cache.visitOrdersForUser("userOdd", [&userOrders](const OrderView&) { ++userOrders; });
+    EXPECT_EQ(userOrders, 5);
+
+    int securityOrders = 0;
+    cache.visitOrdersForSecurity("sec0", [&securityOrders](const OrderView& order) {
+        EXPECT_EQ(order.securityId, "sec0");
+        ++securityOrders;
+    });
+    EXPECT_EQ(securityOrders, 4);
+
+    unsigned int totalQty = 0;
+    cache.visitOrders([&totalQty](const OrderView& order) { totalQty += order.qty; });
+    EXPECT_EQ(totalQty, 100);
+}
+
+TEST(ShardedOrderCacheTest, ConcurrentWritersOnDisjointSecurities) {
+    ShardedOrderCache cache(8);
+    constexpr int threadCount = 8;
+    constexpr int ordersPerThread = 2000;
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threadCount; ++t) {
+        writers.emplace_back([&cache, t] {
+            std::string sec = "sec" + std::to_string(t);
+            std::string user = "user" + std::to_string(t);
+            for (int i = 0; i < ordersPerThread; ++i) {
+                std::string id = "t" + std::to_string(t) + "-" + std::to_string(i);
+                cache.addOrder(Order(id, sec, i % 2 ? "Buy" : "Sell", 10, user, "company" + std::to_string(i % 3)));
+                if (i % 4 == 0) {
+                    cache.cancelOrder(id);
+                }
+            }
+        });
+    }
+    // A concurrent reader must only ever see whole orders
+    std::thread reader([&cache] {
+        for (int i = 0; i < 20; ++i) {
+            for (const auto& order : cache.getAllOrders()) {
+                ASSERT_EQ(order.qty(), 10);
+            }
+        }
+    });
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    reader.join();
+
+    EXPECT_EQ(cache.getAllOrders().size(), threadCount * ordersPerThread * 3 / 4);
+    for (int t = 0; t < threadCount; t += 2) {
+        cache.cancelOrdersForUser("user" + std::to_string(t));
+    }
+    EXPECT_EQ(cache.getAllOrders().size(), threadCount * ordersPerThread * 3 / 8);
+}
+
+TEST(ShardedOrderCacheTest, ParallelReportAndBulkCancelMatchSerial) {
+    ShardedOrderCache serial(8);
+    ShardedOrderCache parallel(8);
+    parallel.setParallelism(4);
+    for (int i = 0; i < 2000; ++i) {
+        Order order("order" + std::to_string(i), "sec" + std::to_string(i % 150), i % 2 ? "Buy" : "Sell",
+                    10 + i % 9, "user" + std::to_string(i % 3), "company" + std::to_string(i % 4));
+        serial.addOrder(order);
+        parallel.addOrder(order);
+    }
+
+    auto report = parallel.getMatchingSizeForAllSecurities();
+    ASSERT_EQ(report, serial.getMatchingSizeForAllSecurities());
+    ASSERT_EQ(report.size(), 150);
+    EXPECT_EQ(report[0].securityId, "sec0");
+    for (const auto& match : report) {
+        EXPECT_EQ(match.matchingSize, serial.getMatchingSizeForSecurity(match.securityId)) << match.securityId;
+    }
+
+    serial.cancelOrdersForUser("user1");
+    parallel.cancelOrdersForUser("user1");
+    EXPECT_EQ(parallel.getMatchingSizeForAllSecurities(), serial.getMatchingSizeForAllSecurities());
+    auto remaining = parallel.getAllOrders();
+    ASSERT_EQ(remaining.size(), serial.getAllOrders().size());
+    EXPECT_TRUE(std::none_of(remaining.begin(), remaining.end(), [](const Order& order) { return order.user() == "user1"; }));
+
+    // Routes of the cancelled orders are gone, so their IDs can move to other shards
+    parallel.addOrder(Order("order1", "secNew", "Buy", 10, "user2", "company1"));
+    parallel.cancelOrder("order1");
+    EXPECT_EQ(parallel.getAllOrders().size(), remaining.size());
+}
+
+TEST(ShardedOrderCacheTest, StatsTimeOperationsAndTotalShards) {
+    ShardedOrderCache cache(4);
+    cache.addOrder(Order("order0", "sec0", "Buy", 100, "user0", "companyA"));  // not timed
+    cache.setStatsEnabled(true);
+    for (int i = 1; i <= 12; ++i) {
+        // One user per security, so no user is counted in two shards
+        cache.addOrder(Order("order" + std::to_string(i), "sec" + std::to_string(i % 6), i % 2 ? "Buy" : "Sell",
+                             100, "user" + std::to_string(i % 6), "company" + std::to_string(i % 4)));
+    }
+    cache.cancelOrder("order1");
+    cache.cancelOrdersForUser("user2");
+    cache.getAllOrders();
+
+    auto snapshot = cache.statsSnapshot();
+    ASSERT_EQ(snapshot.operations.size(), 4);
+    EXPECT_EQ(snapshot.operations[0].name, "addOrder");
+    EXPECT_EQ(snapshot.operations[0].latency.count, 12);
+    EXPECT_EQ(snapshot.operations[0].lockWait.count, 12);
+    EXPECT_EQ(snapshot.operations[1].name, "cancelOrder");
+    // Locks shard by shard, so only its latency is recorded
+    EXPECT_EQ(snapshot.operations[2].name, "cancelOrdersForUser");
+    EXPECT_EQ(snapshot.operations[2].lockWait.count, 0);
+    EXPECT_EQ(snapshot.operations[3].name, "getAllOrders");
+    EXPECT_EQ(snapshot.operations[3].lockWait.count, 1);
+
+    EXPECT_EQ(snapshot.book.orders, 10);
+    EXPECT_EQ(snapshot.book.users, 5);
+    EXPECT_EQ(snapshot.book.securities, 5);
+    ASSERT_FALSE(snapshot.book.tables.empty());
+    EXPECT_EQ(snapshot.book.tables[0].name, "orders");
+    EXPECT_EQ(snapshot.book.tables[0].entries, 10);
+    EXPECT_EQ(snapshot.book.tables[0].usedBuckets + snapshot.book.tables[0].collidedEntries, 10);
+
+    cache.setStatsEnabled(false);
+    cache.cancelOrder("order3");
+    EXPECT_EQ(cache.statsSnapshot().operations[1].latency.count, 1);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
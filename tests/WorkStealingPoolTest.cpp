@@ -0,0 +1,65 @@
+// tests/WorkStealingPoolTest.cpp
+
+#include "../include/WorkStealingPool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(WorkStealingPoolTest, RunsEveryIndexOnce) {
+    for (std::size_t threads : {1, 2, 5}) {
+        WorkStealingPool pool(threads);
+        EXPECT_EQ(pool.concurrency(), threads);
+        for (std::size_t count : {0, 1, 3, 1000}) {
+            std::vector<std::atomic<int>> runs(count);
+            pool.run(count, [&runs](std::size_t index) { runs[index].fetch_add(1); });
+            for (std::size_t index = 0; index < count; ++index) {
+                ASSERT_EQ(runs[index].load(), 1) << "threads " << threads << ", index " << index;
+            }
+        }
+    }
+}
+
+TEST(WorkStealingPoolTest, ConcurrentCallersShareThePool) {
+    WorkStealingPool pool(3);
+    std::vector<std::thread> callers;
+    std::vector<std::uint64_t> sums(4);
+    for (std::size_t caller = 0; caller < sums.size(); ++caller) {
+        callers.emplace_back([&pool, &sums, caller] {
+            std::atomic<std::uint64_t> sum{0};
+            for (int round = 0; round < 50; ++round) {
+                pool.run(100, [&sum](std::size_t index) { sum.fetch_add(index); });
+            }
+            sums[caller] = sum.load();
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    for (std::uint64_t sum : sums) {
+        EXPECT_EQ(sum, 50u * 4950u);
+    }
+}
+
+TEST(WorkStealingPoolTest, RethrowsTaskErrorsAfterAllTasksRan) {
+    WorkStealingPool pool(4);
+    std::atomic<int> ran{0};
+    EXPECT_THROW(pool.run(200, [&ran](std::size_t index) {
+        ran.fetch_add(1);
+        if (index % 50 == 7) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+    EXPECT_EQ(ran.load(), 200);
+
+    // The pool is still usable
+    std::atomic<int> after{0};
+    pool.run(10, [&after](std::size_t) { after.fetch_add(1); });
+    EXPECT_EQ(after.load(), 10);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}